@@ -0,0 +1,96 @@
+#include "ALEvents.h"
+
+#include <stdio.h>
+
+#define SDL_MAIN_HANDLED
+#include <SDL/SDL.h>
+
+static sourceEventQueue eventQueue;
+static SDL_sem* eventSignal = NULL;	// posted once per queued event so the main loop can sleep on it
+static LPALEVENTCALLBACKSOFT eventCallback = NULL;
+static LPALEVENTCONTROLSOFT eventControl = NULL;
+
+bool sourceEventQueue::push(const sourceEvent& e) {
+	unsigned int t = tail.load(std::memory_order_relaxed);
+	if (t - head.load(std::memory_order_acquire) >= AL_EVENT_QUEUE_SIZE) {
+		dropped++;
+		return false;
+	}
+	events[t & (AL_EVENT_QUEUE_SIZE - 1)] = e;
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+bool sourceEventQueue::pop(sourceEvent& e) {
+	unsigned int h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire))
+		return false;
+	e = events[h & (AL_EVENT_QUEUE_SIZE - 1)];
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+//runs on OpenAL's event thread: must not call back into OpenAL, only queue the event
+static void AL_APIENTRY onALEvent(ALenum eventType, ALuint object, ALuint param, ALsizei /*length*/, const ALchar* /*message*/, void* /*userParam*/) AL_API_NOEXCEPT17 {
+	if (eventType != AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT || param != AL_STOPPED)
+		return;
+
+	sourceEvent e = { object, (int)param };
+	if (eventQueue.push(e))
+		SDL_SemPost(eventSignal);
+}
+
+bool initALEvents() {
+	if (!alIsExtensionPresent("AL_SOFT_events")) {
+		printf("AL_SOFT_events not supported, falling back to polling source states\n");
+		return false;
+	}
+
+	eventCallback = (LPALEVENTCALLBACKSOFT)alGetProcAddress("alEventCallbackSOFT");
+	eventControl = (LPALEVENTCONTROLSOFT)alGetProcAddress("alEventControlSOFT");
+	if (eventCallback == NULL || eventControl == NULL)
+		return false;
+
+	eventSignal = SDL_CreateSemaphore(0);
+	eventCallback(onALEvent, NULL);
+	ALenum types[] = { AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT };
+	eventControl(1, types, AL_TRUE);
+	return true;
+}
+
+void shutdownALEvents() {
+	if (eventSignal == NULL)
+		return;
+
+	ALenum types[] = { AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT };
+	eventControl(1, types, AL_FALSE);
+	eventCallback(NULL, NULL);
+	SDL_DestroySemaphore(eventSignal);
+	eventSignal = NULL;
+
+	if (eventQueue.dropped > 0)
+		printf("%i source events were dropped, the queue was full\n", (int)eventQueue.dropped);
+}
+
+bool alEventsEnabled() {
+	return eventSignal != NULL;
+}
+
+bool pollSourceEvent(sourceEvent& e) {
+	if (!eventQueue.pop(e))
+		return false;
+	//keep the semaphore count in step with the queue so the next wait does not wake up for this event
+	if (eventSignal != NULL)
+		SDL_SemTryWait(eventSignal);
+	return true;
+}
+
+void waitForSourceEvent(unsigned int timeoutMs) {
+	if (eventSignal == NULL) {
+		SDL_Delay(timeoutMs);
+		return;
+	}
+
+	//only wakes us up; the event itself stays queued for pollSourceEvent
+	SDL_SemWaitTimeout(eventSignal, timeoutMs);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#ifndef ALEVENTS
+#define ALEVENTS
+#include <atomic>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+#include <AL/alext.h>
+
+// capacity of the event queue, must be a power of two
+#define AL_EVENT_QUEUE_SIZE 1024
+
+struct sourceEvent {
+	unsigned int sourceid;
+	int state;	// AL_STOPPED etc.
+};
+
+/**
+ * single producer / single consumer ring buffer
+ * the producer is OpenAL's event thread, the consumer is the main loop
+ */
+class sourceEventQueue {
+private:
+	sourceEvent events[AL_EVENT_QUEUE_SIZE];
+	std::atomic<unsigned int> head{ 0 };	// next slot to read, owned by the consumer
+	std::atomic<unsigned int> tail{ 0 };	// next slot to write, owned by the producer
+public:
+	std::atomic<int> dropped{ 0 };		// events lost because the queue was full
+
+	bool push(const sourceEvent& e);
+	bool pop(sourceEvent& e);
+};
+
+/**
+ * source completion notifications through AL_SOFT_events
+ * returns false if the extension is missing; callers then have to keep polling AL_SOURCE_STATE
+ */
+bool initALEvents();
+void shutdownALEvents();
+bool alEventsEnabled();
+// takes the oldest pending stop notification. Returns false once the queue is empty
+bool pollSourceEvent(sourceEvent& e);
+// sleeps up to timeoutMs but returns early as soon as a source stops (plain SDL_Delay without events)
+void waitForSourceEvent(unsigned int timeoutMs);
+#endif
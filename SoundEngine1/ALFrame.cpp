@@ -0,0 +1,146 @@
+#include "ALFrame.h"
+#include "ALPool.h"
+
+#include <stdio.h>
+#include <unordered_map>
+
+static LPALDEFERUPDATESSOFT deferUpdates = NULL;
+static LPALPROCESSUPDATESSOFT processUpdates = NULL;
+static bool frameOpen = false;
+
+//last values sent to OpenAL; a flag is false until the value has been sent once
+struct sourceShadow {
+	glm::vec3 pos;
+	float gain = 0;
+	bool looping = false;
+	bool knownPos = false, knownGain = false, knownLooping = false;
+};
+
+struct listenerShadow {
+	glm::vec3 pos, at, up;
+	float gain = 0;
+	bool knownPos = false, knownOrientation = false, knownGain = false;
+};
+
+static std::unordered_map<unsigned int, sourceShadow> sourceShadows;
+static listenerShadow listenerState;
+static ALCallStats callStats;
+
+void initALFrame() {
+	if (!alIsExtensionPresent("AL_SOFT_deferred_updates")) {
+		printf("AL_SOFT_deferred_updates not supported, frame updates are applied immediately\n");
+		return;
+	}
+
+	deferUpdates = (LPALDEFERUPDATESSOFT)alGetProcAddress("alDeferUpdatesSOFT");
+	processUpdates = (LPALPROCESSUPDATESSOFT)alGetProcAddress("alProcessUpdatesSOFT");
+	if (deferUpdates == NULL || processUpdates == NULL) {
+		deferUpdates = NULL;
+		processUpdates = NULL;
+	}
+}
+
+void beginALFrame() {
+	if (frameOpen)
+		return;
+	frameOpen = true;
+	callStats = ALCallStats();
+	if (deferUpdates != NULL)
+		deferUpdates();
+}
+
+void endALFrame() {
+	if (!frameOpen)
+		return;
+	frameOpen = false;
+	if (processUpdates != NULL)
+		processUpdates();
+
+	//sources released during the frame can be detached now that their stop has been applied
+	if (poolsReady())
+		sourcePool().recycleRetired();
+}
+
+bool inALFrame() {
+	return frameOpen;
+}
+
+void setSourcePosition(unsigned int sourceid, glm::vec3 pos) {
+	sourceShadow& shadow = sourceShadows[sourceid];
+	if (shadow.knownPos && shadow.pos == pos) {
+		callStats.skipped++;
+		return;
+	}
+	shadow.pos = pos;
+	shadow.knownPos = true;
+	alSource3f(sourceid, AL_POSITION, pos.x, pos.y, pos.z);
+	callStats.made++;
+}
+
+void setSourceGain(unsigned int sourceid, float gain) {
+	sourceShadow& shadow = sourceShadows[sourceid];
+	if (shadow.knownGain && shadow.gain == gain) {
+		callStats.skipped++;
+		return;
+	}
+	shadow.gain = gain;
+	shadow.knownGain = true;
+	alSourcef(sourceid, AL_GAIN, gain);
+	callStats.made++;
+}
+
+void setSourceLooping(unsigned int sourceid, bool looping) {
+	sourceShadow& shadow = sourceShadows[sourceid];
+	if (shadow.knownLooping && shadow.looping == looping) {
+		callStats.skipped++;
+		return;
+	}
+	shadow.looping = looping;
+	shadow.knownLooping = true;
+	alSourcei(sourceid, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
+	callStats.made++;
+}
+
+void setListenerPosition(glm::vec3 pos) {
+	if (listenerState.knownPos && listenerState.pos == pos) {
+		callStats.skipped++;
+		return;
+	}
+	listenerState.pos = pos;
+	listenerState.knownPos = true;
+	alListener3f(AL_POSITION, pos.x, pos.y, pos.z);
+	callStats.made++;
+}
+
+void setListenerOrientation(glm::vec3 at, glm::vec3 up) {
+	if (listenerState.knownOrientation && listenerState.at == at && listenerState.up == up) {
+		callStats.skipped++;
+		return;
+	}
+	listenerState.at = at;
+	listenerState.up = up;
+	listenerState.knownOrientation = true;
+	float orientation[] = { at.x, at.y, at.z,//forward
+							up.x, up.y, up.z };//up
+	alListenerfv(AL_ORIENTATION, orientation);
+	callStats.made++;
+}
+
+void setListenerGain(float gain) {
+	if (listenerState.knownGain && listenerState.gain == gain) {
+		callStats.skipped++;
+		return;
+	}
+	listenerState.gain = gain;
+	listenerState.knownGain = true;
+	alListenerf(AL_GAIN, gain);
+	callStats.made++;
+}
+
+void forgetSource(unsigned int sourceid) {
+	sourceShadows.erase(sourceid);
+}
+
+const ALCallStats& frameCallStats() {
+	return callStats;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ALFRAME
+#define ALFRAME
+#include <AL/al.h>
+#include <AL/alc.h>
+#include <AL/alext.h>
+
+#include <glm.hpp>
+
+/**
+ * per-frame batching of source and listener changes (AL_SOFT_deferred_updates)
+ * everything set between beginALFrame() and endALFrame() reaches the mixer at once,
+ * so it never plays a half-applied frame
+ * without the extension both calls do nothing and changes apply immediately as before
+ * sources released to the pool inside a frame are only recycled once the frame ends
+ */
+
+// looks up the extension. Call once after the context is made current
+void initALFrame();
+void beginALFrame();
+void endALFrame();
+// true while between beginALFrame() and endALFrame()
+bool inALFrame();
+
+/**
+ * shadow state for sources and the listener
+ * the setters below only call into OpenAL when the value differs from the last one sent,
+ * so code can state the desired value every frame without paying for it
+ * anything changed with plain al* calls must be reported with forgetSource()
+ */
+struct ALCallStats {
+	int made = 0;		// calls forwarded to OpenAL
+	int skipped = 0;	// calls dropped because nothing changed
+};
+
+void setSourcePosition(unsigned int sourceid, glm::vec3 pos);
+void setSourceGain(unsigned int sourceid, float gain);
+void setSourceLooping(unsigned int sourceid, bool looping);
+void setListenerPosition(glm::vec3 pos);
+void setListenerOrientation(glm::vec3 at, glm::vec3 up);
+void setListenerGain(float gain);
+// drops the cached state of a source so the next set always reaches OpenAL
+void forgetSource(unsigned int sourceid);
+// counts since the last beginALFrame()
+const ALCallStats& frameCallStats();
+#endif
@@ -0,0 +1,154 @@
+#include "ALPool.h"
+#include "ALFrame.h"
+
+#include <stdio.h>
+
+static ALObjectPool* globalSourcePool = NULL;
+static ALObjectPool* globalBufferPool = NULL;
+
+ALObjectPool::ALObjectPool(Kind _kind, int _capacity, int prewarm) : kind(_kind), capacity(_capacity) {
+	if (prewarm > capacity)
+		prewarm = capacity;
+
+	freeList.resize(prewarm);
+	if (prewarm > 0) {
+		alGetError(); //clear stale errors so the check below is about this call
+		if (kind == SOURCES)
+			alGenSources(prewarm, freeList.data());
+		else
+			alGenBuffers(prewarm, freeList.data());
+
+		if (alGetError() != AL_NO_ERROR) {
+			printf("AL pool could not prewarm %i objects\n", prewarm);
+			freeList.clear();
+		}
+	}
+}
+
+ALObjectPool::~ALObjectPool() {
+	recycleRetired();
+	if (freeList.empty())
+		return;
+
+	if (kind == SOURCES) {
+		for (int i = 0; i < freeList.size(); i++)
+			forgetSource(freeList[i]);
+		alDeleteSources((int)freeList.size(), freeList.data());
+	}
+	else
+		alDeleteBuffers((int)freeList.size(), freeList.data());
+}
+
+unsigned int ALObjectPool::acquire() {
+	unsigned int id = 0;
+
+	if (!freeList.empty()) {
+		id = freeList.back();
+		freeList.pop_back();
+		stats.hits++;
+	}
+	else {
+		alGetError();
+		if (kind == SOURCES)
+			alGenSources(1, &id);
+		else
+			alGenBuffers(1, &id);
+		if (alGetError() != AL_NO_ERROR)
+			return 0; // out of sources, see the 256 source limit in the README
+		stats.misses++;
+	}
+
+	stats.inUse++;
+	if (stats.inUse > stats.highWater)
+		stats.highWater = stats.inUse;
+	return id;
+}
+
+void ALObjectPool::release(unsigned int id) {
+	if (id == 0)
+		return;
+	stats.inUse--;
+
+	if (kind == SOURCES) {
+		//inside a deferred frame the stop may not be applied yet, and a playing source cannot be detached
+		alSourceStop(id);
+		int state;
+		alGetSourcei(id, AL_SOURCE_STATE, &state);
+		if (state == AL_PLAYING || state == AL_PAUSED) {
+			retired.push_back(id);
+			return;
+		}
+		reset(id);
+	}
+
+	recycle(id);
+}
+
+//a recycled source must not carry over anything from its previous user
+void ALObjectPool::reset(unsigned int id) {
+	alSourcei(id, AL_BUFFER, 0);
+	setSourceLooping(id, false);
+	setSourceGain(id, 1.0f);
+	setSourcePosition(id, glm::vec3(0, 0, 0));
+}
+
+void ALObjectPool::recycle(unsigned int id) {
+	if ((int)freeList.size() < capacity) {
+		freeList.push_back(id);
+		return;
+	}
+
+	if (kind == SOURCES) {
+		forgetSource(id);
+		alDeleteSources(1, &id);
+	}
+	else
+		alDeleteBuffers(1, &id);
+}
+
+void ALObjectPool::recycleRetired() {
+	for (int i = 0; i < retired.size(); i++) {
+		reset(retired[i]);
+		recycle(retired[i]);
+	}
+	retired.clear();
+}
+
+void ALObjectPool::resetStats() {
+	int inUse = stats.inUse;
+	stats = ALPoolStats();
+	stats.inUse = inUse;
+	stats.highWater = inUse;
+}
+
+void initALPools(int sourceCapacity, int bufferCapacity) {
+	//sources are prewarmed so the ray tracer never allocates mid-frame
+	globalSourcePool = new ALObjectPool(ALObjectPool::SOURCES, sourceCapacity, sourceCapacity);
+	globalBufferPool = new ALObjectPool(ALObjectPool::BUFFERS, bufferCapacity, sourceCapacity);
+}
+
+void freeALPools() {
+	delete globalSourcePool;
+	delete globalBufferPool;
+	globalSourcePool = NULL;
+	globalBufferPool = NULL;
+}
+
+bool poolsReady() {
+	return globalSourcePool != NULL;
+}
+
+ALObjectPool& sourcePool() {
+	return *globalSourcePool;
+}
+
+ALObjectPool& bufferPool() {
+	return *globalBufferPool;
+}
+
+void printPoolStats() {
+	const ALPoolStats& s = globalSourcePool->getStats();
+	const ALPoolStats& b = globalBufferPool->getStats();
+	printf("source pool: %i hits, %i misses, %i in use, high-water %i\n", s.hits, s.misses, s.inUse, s.highWater);
+	printf("buffer pool: %i hits, %i misses, %i in use, high-water %i\n", b.hits, b.misses, b.inUse, b.highWater);
+}
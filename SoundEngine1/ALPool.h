@@ -0,0 +1,59 @@
+#pragma once
+#ifndef ALPOOL
+#define ALPOOL
+#include <vector>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+
+struct ALPoolStats {
+	int hits = 0;		// acquires served from the free list
+	int misses = 0;		// acquires that had to call alGen*
+	int inUse = 0;		// objects currently handed out
+	int highWater = 0;	// most objects ever handed out at once
+};
+
+/**
+ * recycles OpenAL sources or buffers instead of generating and deleting them
+ * keeps at most `capacity` idle objects around; anything released beyond that is deleted
+ */
+class ALObjectPool {
+public:
+	enum Kind { SOURCES, BUFFERS };
+private:
+	Kind kind;
+	int capacity;
+	std::vector<unsigned int> freeList;
+	std::vector<unsigned int> retired;	// sources released while their stop was still deferred
+	ALPoolStats stats;
+
+	void reset(unsigned int id);
+	void recycle(unsigned int id);
+public:
+	// generates `prewarm` objects up front so the first acquires are hits
+	ALObjectPool(Kind _kind, int _capacity, int prewarm = 0);
+	~ALObjectPool();
+	ALObjectPool(const ALObjectPool&) = delete;
+	ALObjectPool& operator=(const ALObjectPool&) = delete;
+
+	// returns a ready to use object id, or 0 if OpenAL could not create one
+	unsigned int acquire();
+	// hands an object back. Sources are stopped, detached and reset to default state
+	void release(unsigned int id);
+
+	// finishes releasing sources whose stop was deferred (see ALFrame.h). Called by endALFrame()
+	void recycleRetired();
+
+	const ALPoolStats& getStats() const { return stats; }
+	int idle() const { return (int)freeList.size(); }
+	void resetStats();
+};
+
+// global source/buffer pools. Must be created after the context is current and freed before it is destroyed
+void initALPools(int sourceCapacity = 192, int bufferCapacity = 512);
+void freeALPools();
+ALObjectPool& sourcePool();
+ALObjectPool& bufferPool();
+bool poolsReady();
+void printPoolStats();
+#endif
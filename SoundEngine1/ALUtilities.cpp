@@ -1,4 +1,21 @@
 #include "ALUtilities.h"
+#include "AudioStream.h"
+#include "ThreadPool.h"
+#include "ALFrame.h"
+
+#include <chrono>
+#include <cmath>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 #pragma region WAV_loaders
@@ -68,6 +85,133 @@ char* loadWAV(std::string filename, int& channel, int& sampleRate, int& bps, int
 	printf("%s successfully loaded\nchannel: %i; sample rate: %i; bits per second: %i, audio size: %i\n", filename.c_str(), channel, sampleRate, bps, size);
 	return data;
 }
+
+/**
+ * maps the whole file read-only into memory
+ * returns false (and leaves the mapping empty) if the file cannot be mapped
+ */
+bool mapFile(std::string filename, mappedFile& mapping) {
+	mapping = mappedFile();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (fileMapping == NULL) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) {
+		CloseHandle(fileMapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mapping.view = (char*)view;
+	mapping.length = (size_t)fileSize.QuadPart;
+	mapping.fileHandle = file;
+	mapping.mappingHandle = fileMapping;
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping keeps its own reference to the file
+	if (view == MAP_FAILED)
+		return false;
+
+	mapping.view = (char*)view;
+	mapping.length = (size_t)st.st_size;
+#endif
+	return true;
+}
+
+//releases a mapping created by mapFile. Safe to call on an empty mapping
+void unmapFile(mappedFile& mapping) {
+	if (mapping.view == NULL)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(mapping.view);
+	CloseHandle((HANDLE)mapping.mappingHandle);
+	CloseHandle((HANDLE)mapping.fileHandle);
+#else
+	munmap(mapping.view, mapping.length);
+#endif
+	mapping = mappedFile();
+}
+
+/**
+ * memory-maps a WAV file and parses its RIFF chunks in place
+ * returns a pointer into the mapping at the start of the sample data (nothing is copied)
+ * the returned pointer stays valid until unmapFile(mapping) is called
+ */
+char* loadWAVMapped(std::string filename, mappedFile& mapping, int& channel, int& sampleRate, int& bps, int& size) {
+	if (!mapFile(filename, mapping)) {
+		std::cout << "WAV file could not be mapped: " << filename << std::endl;
+		return NULL;
+	}
+
+	char* file = mapping.view;
+	size_t length = mapping.length;
+
+	if (length < 12 || strncmp(file, "RIFF", 4) != 0 || strncmp(file + 8, "WAVE", 4) != 0) {
+		std::cout << "WAV file does not use RIFF/WAVE: " << filename << std::endl;
+		unmapFile(mapping);
+		return NULL;
+	}
+
+	// walk the chunk list; unlike loadWAV this does not assume a 44 byte header
+	char* data = NULL;
+	bool foundFormat = false;
+	size_t offset = 12;
+	while (offset + 8 <= length) {
+		char* chunk = file + offset;
+		size_t chunkSize = (unsigned int)charToInt(chunk + 4, 4);
+		char* body = chunk + 8;
+
+		if (strncmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+			channel = charToInt(body + 2, 2);
+			sampleRate = charToInt(body + 4, 4);
+			bps = charToInt(body + 14, 2);
+			foundFormat = true;
+		}
+		else if (strncmp(chunk, "data", 4) == 0) {
+			// clamp truncated files to what is actually on disk
+			if (chunkSize > length - (offset + 8))
+				chunkSize = length - (offset + 8);
+			data = body;
+			size = (int)chunkSize;
+			break;
+		}
+
+		offset += 8 + chunkSize + (chunkSize & 1); // chunks are padded to even sizes
+	}
+
+	if (!foundFormat || data == NULL) {
+		std::cout << "WAV file is missing its fmt or data chunk: " << filename << std::endl;
+		unmapFile(mapping);
+		return NULL;
+	}
+
+	printf("%s successfully mapped\nchannel: %i; sample rate: %i; bits per second: %i, audio size: %i\n", filename.c_str(), channel, sampleRate, bps, size);
+	return data;
+}
 #pragma endregion WAV_loaders
 
 #pragma region prototypes
@@ -111,10 +255,22 @@ void freeContext(ALCdevice* device, ALCcontext* context) {
 
 //deletes the loaded elements of the given sound file, as well as its buffers
 void deleteSoundFile(soundFile &sf){
+	forgetSource(sf.sourceid);
+	if (sf.stream != NULL) {
+		closeStream(sf.stream);
+		sf.stream = NULL;
+		alDeleteSources(1, &(sf.sourceid));
+		return;
+	}
+
 	alDeleteSources(1, &(sf.sourceid));
-	alDeleteBuffers(1, &(sf.bufferid));
+	alDeleteBuffers(1, &(sf.bufferid)); // must happen before unmapping, a static buffer may still reference the mapping
 
-	delete[] sf.wavFile;
+	if (sf.mapping.view != NULL)
+		unmapFile(sf.mapping);
+	else
+		delete[] sf.wavFile;
+	sf.wavFile = NULL;
 }
 
 //deletes all sound file instances
@@ -177,48 +333,164 @@ void getAudioFormat(int channel, int bps, unsigned int& format) {
 }
 
 void initAudioSource(soundFile& sFile) {
+	//streamed files bring their own buffer ring
+	if (sFile.stream != NULL) {
+		sFile.bufferid = 0;
+		alGenSources(1, &(sFile.sourceid));
+		startStream(sFile.stream, sFile.sourceid);
+		return;
+	}
+
 	//create sound buffer
 	unsigned int format;
 	alGenBuffers(1, &(sFile.bufferid));
 
 	getAudioFormat(sFile.channel, sFile.bps, format);
-	alBufferData(sFile.bufferid, format, sFile.wavFile, sFile.size, sFile.sampleRate);
+
+	// mapped files can be handed to OpenAL without a copy if AL_EXT_STATIC_BUFFER is available
+	static PFNALBUFFERDATASTATICPROC bufferDataStatic = alIsExtensionPresent("AL_EXT_STATIC_BUFFER") ?
+		(PFNALBUFFERDATASTATICPROC)alGetProcAddress("alBufferDataStatic") : NULL;
+	if (sFile.mapping.view != NULL && bufferDataStatic != NULL)
+		bufferDataStatic(sFile.bufferid, format, sFile.wavFile, sFile.size, sFile.sampleRate);
+	else
+		alBufferData(sFile.bufferid, format, sFile.wavFile, sFile.size, sFile.sampleRate);
 
 	//create a sound source
 	alGenSources(1, &(sFile.sourceid)); //create 1 source into sourceid
 	alSourcei(sFile.sourceid, AL_BUFFER, sFile.bufferid); // attach ONE(i) buffer to source
 }
 
-soundFile createSoundFile(std::string fileName)
+//plays the sound from the start, streamed or not
+void playSound(soundFile& sFile) {
+	if (sFile.stream != NULL)
+		playStream(sFile.stream);
+	else
+		alSourcePlay(sFile.sourceid);
+}
+
+void stopSound(soundFile& sFile) {
+	if (sFile.stream != NULL)
+		stopStream(sFile.stream);
+	else
+		alSourceStop(sFile.sourceid);
+}
+
+//AL_LOOPING would replay the queued chunks of a stream, so streams rewind the file instead
+void setSoundLooping(soundFile& sFile, bool looping) {
+	if (sFile.stream != NULL)
+		sFile.stream->looping = looping;
+	else
+		setSourceLooping(sFile.sourceid, looping);
+}
+
+soundFile createSoundFile(std::string fileName, LoadMode mode)
 {
 	soundFile newFile(fileName);
 
+	if (mode == LOAD_STREAM) {
+		newFile.wavFile = NULL;
+		newFile.stream = openStream(newFile.name, newFile.channel, newFile.sampleRate, newFile.bps, newFile.size);
+		if (newFile.stream != NULL)
+			return newFile;
+		std::cout << "falling back to copying " << fileName << std::endl;
+	}
+	else if (mode == LOAD_MAPPED) {
+		newFile.wavFile = loadWAVMapped(newFile.name, newFile.mapping, newFile.channel, newFile.sampleRate, newFile.bps, newFile.size);
+		if (newFile.wavFile != NULL)
+			return newFile;
+		std::cout << "falling back to copying " << fileName << std::endl;
+	}
+
 	newFile.wavFile = loadWAV(newFile.name, newFile.channel, newFile.sampleRate, newFile.bps, newFile.size);
 
 	return newFile;
 }
 
-std::vector<soundFile*> createSounds(std::vector<std::string>& files)
+/**
+ * loads and parses all files in parallel on the shared worker pool
+ * only the AL buffer/source creation runs on the calling (context) thread
+ * prints the load time of every file and of the whole batch
+ */
+std::vector<soundFile*> createSounds(std::vector<std::string>& files, LoadMode mode)
 {
-	std::vector<soundFile*> allSoundFiles;
+	typedef std::chrono::steady_clock clock;
+	clock::time_point batchStart = clock::now();
+
+	std::vector<soundFile*> allSoundFiles(files.size());
+	std::vector<double> loadMs(files.size());
+
+	//disk reads and header parsing
+	sharedPool().parallelFor((int)files.size(), [&](int i) {
+		clock::time_point start = clock::now();
+		allSoundFiles[i] = new soundFile(createSoundFile(files[i], mode));
+		loadMs[i] = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	});
+
+	//AL handoff
+	for (int i = 0; i < allSoundFiles.size(); i++) {
+		clock::time_point start = clock::now();
+		initAudioSource(*allSoundFiles[i]);
+		double uploadMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+		printf("%s: load %.2f ms, upload %.2f ms\n", files[i].c_str(), loadMs[i], uploadMs);
+	}
 
-	for (int i = 0; i < files.size(); i++) {
-		soundFile* newSound = new soundFile(files[i]);
-		*newSound = createSoundFile(files[i]);
-		initAudioSource(*newSound);
+	printf("loaded %i sound files in %.2f ms\n", (int)files.size(),
+		std::chrono::duration<double, std::milli>(clock::now() - batchStart).count());
+	return allSoundFiles;
+}
 
-		allSoundFiles.push_back(newSound);
+/**
+ * finds the fewest periods whose length is within tolerance of a whole number of samples
+ * and renders exactly that many periods, so looping the buffer has no seam
+ * rounding n periods to whole samples is off by at most half a sample, so the search always
+ * stops at the latest once n periods cover 0.5 / tolerance (5000) samples
+ * frequencies that are not positive or above Nyquist leave the buffer empty
+ */
+void sineW::generate() {
+	const double tolerance = 1e-4; // relative pitch error, about 0.17 cents
+
+	if (!std::isfinite(freq) || freq <= 0 || sample_rate == 0 || freq > sample_rate / 2.0f) {
+		fprintf(stderr, "sineW: cannot generate %f Hz at a sample rate of %u\n", freq, sample_rate);
+		buf_size = 0;
+		samples.clear();
+		return;
 	}
 
-	return allSoundFiles;
+	//at least 2 samples per period here, so this stays below 2600
+	double samplesPerPeriod = double(sample_rate) / freq;
+	int maxPeriods = (int)ceil((0.5 / tolerance + 1) / samplesPerPeriod);
+	int periods = 1;
+	for (; periods < maxPeriods; periods++) {
+		double exact = samplesPerPeriod * periods;
+		double rounded = floor(exact + 0.5);
+		if (rounded >= 1 && fabs(exact - rounded) / rounded < tolerance)
+			break;
+	}
+
+	buf_size = (size_t)floor(samplesPerPeriod * periods + 0.5);
+	actualFreq = float(double(periods) * sample_rate / buf_size);
+
+	samples.resize(buf_size);
+	WavetableOscillator osc(wave, actualFreq, sample_rate);
+	osc.fill(samples.data(), (int)buf_size);
+
+	alBufferData(bufferid, AL_FORMAT_MONO16, samples.data(), (int)(buf_size * sizeof(short)), sample_rate);
+}
+
+void sineW::play() {
+	alSourcei(sourceid, AL_BUFFER, bufferid);
+	setSourceLooping(sourceid, true);
+	alSourcePlay(sourceid);
 }
 
 /**
  * moves sound sources on the x-z plane according to the keyboard input
  */
-void keyInput(bool& running, float speed, float sensitivity, Listener& player, std::vector<soundFile*> &sounds) {
+void keyInput(bool& running, float speed, float sensitivity, Listener& player, std::vector<soundFile*> &sounds, std::vector<ProceduralSource*>* procedurals) {
 	SDL_Event event;
 	glm::vec3 position;
+	int key;
 
 	while (SDL_PollEvent(&event)) {
 		switch (event.type) {
@@ -231,21 +503,21 @@ void keyInput(bool& running, float speed, float sensitivity, Listener& player, s
 			//stop all sounds
 			case SDLK_QUOTEDBL:
 				for (int i = 0; i < sounds.size(); i++)
-					alSourceStop(sounds[i]->sourceid);
+					stopSound(*sounds[i]);
+				if (procedurals != NULL)
+					for (int i = 0; i < procedurals->size(); i++)
+						(*procedurals)[i]->stop();
 				break;
 			//play a sound associated with this keybind
-			case SDLK_1:
-				alSourcePlay(sounds[0]->sourceid);
-				//can also use Stop Pause Rewind instead of Play
-				break;
-			case SDLK_2:
-				alSourcePlay(sounds[1]->sourceid);
-				break;
-			case SDLK_3:
-				alSourcePlay(sounds[2]->sourceid);
-				break;
-			case SDLK_4:
-				alSourcePlay(sounds[3]->sourceid);
+			//can also use Stop Pause Rewind instead of Play
+			case SDLK_1: case SDLK_2: case SDLK_3:
+			case SDLK_4: case SDLK_5: case SDLK_6:
+			case SDLK_7: case SDLK_8: case SDLK_9:
+				key = event.key.keysym.sym - SDLK_1;
+				if (key < sounds.size())
+					playSound(*sounds[key]);
+				else if (procedurals != NULL && key - sounds.size() < procedurals->size())
+					(*procedurals)[key - sounds.size()]->play();
 				break;
 			//////////////////////////////////////
 			//misc. keybinds
@@ -312,25 +584,21 @@ void keyInput(bool& running, float speed, float sensitivity, Listener& player, s
 }
 
 void setListenerAngle(float angle, Listener& player) {
-	//move player to origin
-	glm::vec3 position(0, 0, 0);
-	float xOffset = player.pos.x;
-	float yOffset = player.pos.y;
-	float zOffset = player.pos.z;
-	moveListener(position, player);
+	//look-at point relative to the player, so the turn happens around the player
+	float xOffset = player.f.x - player.pos.x;
+	float zOffset = player.f.z - player.pos.z;
 
 	//turn player
 	float sinAngle = sin(angle);
 	float cosAngle = cos(angle);
-	float newX = (player.f.x * cosAngle) - (player.f.z * sinAngle);
-	float newZ = (player.f.x * sinAngle) + (player.f.z * cosAngle);
+	float newX = (xOffset * cosAngle) - (zOffset * sinAngle);
+	float newZ = (xOffset * sinAngle) + (zOffset * cosAngle);
 
-	player.f.x = newX;
-	player.f.z = newZ;
+	player.f.x = player.pos.x + newX;
+	player.f.z = player.pos.z + newZ;
 
-	//move player back to where it was
-	position = glm::vec3(xOffset, yOffset, zOffset);
-	moveListener(position, player);
+	//only the orientation changed; the shadow state drops it if the angle was 0
+	setListenerOrientation(player.f, player.up);
 }
 
 /**
@@ -346,227 +614,13 @@ void moveListener(glm::vec3 position, Listener& player) {
 	player.pos.x = position.x;
 	player.pos.y = position.y;
 	player.pos.z = position.z;
-	float playerPos[] = { player.pos.x, player.pos.y, player.pos.z };
-	alListenerfv(AL_POSITION, playerPos);
+	setListenerPosition(player.pos);
 
 	// Keep the listener facing the same direction by
 	// moving the "look at" point by the offset values:
 	player.f.x += xOffset;
 	player.f.y += yOffset;
 	player.f.z += zOffset;
-	float playerLookAt[] = { player.f.x,  player.f.y,  player.f.z,//forward
-							 player.up.x, player.up.y, player.up.z }; // up
-	alListenerfv(AL_ORIENTATION, playerLookAt);
+	setListenerOrientation(player.f, player.up);
 }
 #pragma endregion prototypes
-
-
-//Reverses the calculated order of reflection absorptions
-void ReverseAbsorptionOrder(std::vector<reflectInfo> &reflectedSources) {
-	float totalDampen = 1;
-
-	for (int i = reflectedSources.size() - 1; i >= 0; i--) {
-		totalDampen *= reflectedSources[i].hit.mtl.soundDampenPercent();
-		reflectedSources[i].totalAbsorbed = totalDampen;
-	}
-}
-
-// Intersects the given ray with all spheres in the scene
-// and updates the given HitInfo using the information of the sphere
-// that first intersects with the ray.
-// Returns true if an intersection is found.
-bool IntersectRaySphere(HitInfo& hit, Ray ray) {
-	hit.t = 1e30;
-	bool foundHit = false;
-
-	//TODO: remove these from the class. These should not be here, keep them in main
-	//fucky wucky solution
-	std::vector<Sphere> spheres;
-
-	spheres.push_back( Sphere(glm::vec3(3, 0, 0), 2) );
-	spheres.push_back( Sphere(glm::vec3(0, 0, 0), 1, true) ); // sound source
-
-
-	for (int i = 0; i < spheres.size(); ++i) {
-		Sphere sphere = spheres[i];
-
-		// Test for ray-sphere intersection; b^2 - 4ac
-		float discriminant = pow(glm::dot(ray.getDir(), (ray.getOrig() - sphere.center)), 2.0) -
-			(glm::dot(ray.getDir(), ray.getDir()) * (glm::dot((ray.getOrig() - sphere.center), (ray.getOrig() - sphere.center)) - pow(sphere.radius, 2.0)));
-
-		if (discriminant >= 0.0) { // hit found
-			// find the t value of closet ray-sphere intersection
-			float t0;
-			if (glm::distance(ray.getOrig(), sphere.center) > sphere.radius) //finds hit facing you (use if outside sphere)
-				t0 = (-(glm::dot(ray.getDir(), (ray.getOrig() - sphere.center))) - sqrt(discriminant)) / (glm::dot(ray.getDir(), ray.getDir()));
-			else //finds hit facing from you (use if inside sphere)
-				t0 = (-(glm::dot(ray.getDir(), (ray.getOrig() - sphere.center))) + sqrt(discriminant)) / (glm::dot(ray.getDir(), ray.getDir()));
-
-			// If intersection is found, update the given HitInfo
-			if (t0 > 0.0 && t0 <= hit.t) {
-				foundHit = true;
-
-				hit.t = t0;
-				hit.position = ray.getOrig() + (ray.getDir() * t0);
-				hit.normal = normalize((hit.position - sphere.center) / sphere.radius);
-
-				hit.mtl = sphere.mtl;
-			}
-		}
-	}
-	return foundHit;
-}
-
-// Intersects the given ray with triangles in the scene
-// and updates the given HitInfo using the information of the triangle
-// that first intersects with the ray.
-// Returns true if an intersection is found.
-bool IntersectRayTriangle(HitInfo& hit, Ray ray) {
-	hit.t = 1e30;
-	bool foundHit = false;
-
-	std::vector<Triangle> triangles;
-
-	triangles.push_back( Triangle(glm::vec3(1, -1, 0), glm::vec3(-1, -1, 0), glm::vec3(0, -1, 1)) );
-	triangles.push_back( Triangle(glm::vec3(-1, -1, 0), glm::vec3(1, -1, 0), glm::vec3(0, -1, -1)) );
-
-	for (int i = 0; i < triangles.size(); ++i) {
-		Triangle& tri = triangles[i];
-
-		//calculate the normal of the triangle
-		glm::vec3 edge1 = tri.v1 - tri.v0;
-		glm::vec3 edge2 = tri.v2 - tri.v0;
-		glm::vec3 h = glm::cross(ray.getDir(), edge2);
-		float a = glm::dot(edge1, h);
-
-		#pragma region CheckIntersection
-		if (a > -1e-7 && a < 1e-7) // This means the ray is parallel to the triangle. No intersection so we skip this triangle
-			continue;
-
-		// Compute the factor to check if the intersection point is inside the triangle
-		float f = 1.0 / a;
-		glm::vec3 s = ray.getOrig() - tri.v0;
-		float u = f * glm::dot(s, h);
-
-		if (u < 0.0 || u > 1.0)
-			continue; // The intersection point is outside the triangle
-
-		glm::vec3 q = glm::cross(s, edge1);
-		float v = f * glm::dot(ray.getDir(), q);
-
-		if (v < 0.0 || u + v > 1.0)
-			continue; // The intersection point is outside the triangle
-		#pragma endregion CheckIntersection
-
-		//We know that there is an intersection with the triangle
-		// So we can compute t to find out where the intersection point is on the line.
-		float t = f * glm::dot(edge2, q);
-
-		if (t > 1e-7) { // Ray intersection
-			if (t < hit.t) { // Check if this is the closest intersection so far
-				foundHit = true;
-				hit.t = t;
-				hit.position = ray.getOrig() + ray.getDir() * t;
-				hit.normal = normalize(glm::cross(edge1, edge2)); // Compute normal at the intersection point
-				hit.mtl = tri.mtl;
-			}
-		}
-	}
-
-	return foundHit;
-}
-
-
-//TODO: modify this. It only computes light rendering at a point. But we can hear places we cannot see. We need to return sound sources at all intersection points
-// Given a ray, returns the sound where the ray intersects a sphere.
-// If the ray does not hit a sphere, returns nothing.
-std::vector<reflectInfo> RayTracer(Ray ray) {
-	HitInfo hit;
-	std::vector<reflectInfo> reflectedSources; // stores all sound source instances, the returned ones will play one bit of sound
-	int MAX_BOUNCES = 3;
-	bool hitFound = false;
-
-	#pragma region CheckIntersection
-	// Check for sphere intersection
-	hitFound = IntersectRaySphere(hit, ray);
-
-	// Check for triangle intersection
-	HitInfo triangleHit;
-	if (IntersectRayTriangle(triangleHit, ray) && (!hitFound || triangleHit.t < hit.t)) {
-		hit = triangleHit;
-		hitFound = true;
-	}
-	#pragma endregion CheckIntersection
-
-	if (hitFound) {
-		glm::vec3 view = normalize(-ray.getDir());
-		reflectInfo newReflectedSound(hit);
-		reflectedSources.push_back(newReflectedSound);
-		if (hit.mtl.isSource) return reflectedSources; // if the hit object is a sound source, stop tracing reflections
-
-		// Compute reflections
-		for (int bounce = 0; bounce < MAX_BOUNCES; ++bounce) {
-
-			Ray r;	// this is the new reflection ray
-			HitInfo h;	// reflection new hit info
-			bool reflectionHitFound = false;
-
-			// Initialize the reflection ray
-			r.setDir(normalize(ray.getDir()) - 2 * dot(normalize(ray.getDir()), hit.normal) * hit.normal);
-			r.setOrig(hit.position + r.getDir() * 0.0001f);
-
-			#pragma region CheckIntersection
-			// Check for sphere intersection
-			reflectionHitFound = IntersectRaySphere(h, r);
-
-			// Check for triangle intersection
-			HitInfo triangleReflectionHit;
-			if (IntersectRayTriangle(triangleReflectionHit, r) && (!reflectionHitFound || triangleReflectionHit.t < h.t)) {
-				h = triangleReflectionHit;
-				reflectionHitFound = true;
-			}
-			#pragma endregion CheckIntersection
-
-			if (reflectionHitFound) {
-				// TODO: Hit found, so make a sound at the hit point (not implemented)
-				reflectInfo newReflectedSound(h, reflectedSources.back().totalAbsorbed);
-				reflectedSources.push_back(newReflectedSound);
-
-				ReverseAbsorptionOrder(reflectedSources);
-				if (h.mtl.isSource) return reflectedSources; // if the hit object is a sound source, stop tracing reflections
-
-				// Update the loop variables for tracing the next reflection ray
-				hit = h;
-				ray = r;
-			}
-			else {
-				// TODO: The refleciton ray did not intersect with anything,
-				// so we are using the environment sound (not implemented)
-				//clr += k_s * textureCube(envMap, r.dir.xzy).rgb;
-				break;	// no more reflections
-			}
-		}
-
-		//returns empty source buffer cuz no sound source was hit
-		for (int i = 0; i < reflectedSources.size(); i++) {
-			alDeleteSources(1, &(reflectedSources[i].sound.sourceid));
-			alDeleteBuffers(1, &(reflectedSources[i].sound.bufferid));
-		}
-		reflectedSources.clear();
-		return reflectedSources;	// TODO: return the environment sound
-	}
-	else
-		//returns empty source buffer
-		return reflectedSources;	// TODO: return the environment sound
-}
-
-float get_random() {
-	static std::default_random_engine e;
-	static std::uniform_real_distribution<> dis(-1, 1); // range [0, 1)
-	return dis(e);
-}
-
-Ray GetRandomRay(Listener listener) {
-	//Ray newRay(listener.pos, glm::vec3(get_random(), get_random(), get_random()));
-	return Ray(listener.pos, glm::vec3(get_random(), get_random(), get_random()));
-}
\ No newline at end of file
@@ -7,20 +7,44 @@
 #include <string>
 #include <math.h>
 #include <vector>
-#include <random>
 
 #include <AL/al.h>
 #include <AL/alc.h>
+#include <AL/alext.h>
 
 #include <glm.hpp>
 
+#include "ALPool.h"
+#include "Wavetable.h"
+#include "ProceduralSource.h"
+
 #define SDL_MAIN_HANDLED
 #include <SDL/SDL.h>
 
+// how the sample data of a soundFile is brought into memory
+enum LoadMode {
+	LOAD_COPY,		// read the whole file into a new[] buffer (default)
+	LOAD_MAPPED,	// memory-map the file and point straight into the mapping
+	LOAD_STREAM		// keep only a small ring of buffers resident and refill it from disk (see AudioStream.h)
+};
+
+struct wavStream;
+
+// read-only view of a whole file mapped into the address space
+struct mappedFile {
+	char*	view = NULL;	// start of the file contents
+	size_t	length = 0;		// bytes in the view
+	void*	fileHandle = NULL;		// platform handles, only meaningful while view != NULL
+	void*	mappingHandle = NULL;
+};
+
 // WAV_loaders
 bool isBigEndian();
 int charToInt(char* buffer, int len);
 char* loadWAV(std::string filename, int& channel, int& sampleRate, int& bps, int& size);
+bool mapFile(std::string filename, mappedFile& mapping);
+void unmapFile(mappedFile& mapping);
+char* loadWAVMapped(std::string filename, mappedFile& mapping, int& channel, int& sampleRate, int& bps, int& size);
 
 #pragma region structs
 struct Listener {
@@ -38,6 +62,8 @@ struct soundFile {
 	std::string name;
 	int channel, sampleRate, bps, size;
 	char* wavFile;
+	mappedFile mapping;	// non-empty if wavFile points into a memory-mapped file (LOAD_MAPPED)
+	wavStream* stream = NULL; // non-NULL if the file is streamed (LOAD_STREAM), wavFile is unused then
 	glm::vec3 pos = glm::vec3(0, 0, 0); // sound position
 	unsigned int sourceid, bufferid; // post-initialization
 
@@ -48,14 +74,22 @@ struct soundFile {
 template <typename T> int sgn(T val) {
 	return (T(0) < val) - (val < T(0));
 }
-struct sineW { //https://stackoverflow.com/questions/5469030/c-play-back-a-tone-generated-from-a-sinusoidal-wave
+/**
+ * static looping tone //https://stackoverflow.com/questions/5469030/c-play-back-a-tone-generated-from-a-sinusoidal-wave
+ * a steady tone repeats exactly, so the buffer only holds the smallest whole number of periods
+ * that also fits a whole number of samples, and AL_LOOPING plays it for as long as needed
+ * (2205 samples for 440 Hz at 22050 Hz instead of seconds * sample_rate)
+ */
+struct sineW {
 	unsigned int sourceid, bufferid;//required at post-initialization
-	float freq;						//frequency of sine wave
-	int seconds;					//how long it is active (ideally for one phase)
-	unsigned int sample_rate;		//sample rate of the sine wave
-	size_t buf_size;				//calculated by: seconds * sample_rate
+	float freq;						//requested frequency of the wave
+	float actualFreq;				//frequency after fitting whole periods into whole samples
+	int seconds;					//how long the caller means to play it. The buffer itself loops
+	unsigned int sample_rate;		//sample rate of the wave
+	Waveform wave;					//band-limited waveform, see Wavetable.h
+	size_t buf_size;				//samples in the buffer: a whole number of periods
 
-	short* samples;					//array: new short[buf_size]
+	std::vector<short> samples;		//owned sample memory, freed with the object
 
 	int getState() {
 		int State;
@@ -63,46 +97,41 @@ struct sineW { //https://stackoverflow.com/questions/5469030/c-play-back-a-tone-
 		return State;
 	}
 
-	sineW(float _freq = 440, int _seconds = 1, unsigned int _sample_rate = 22050, bool generateBuffer = true)
-		: freq(_freq), seconds(_seconds), sample_rate(_sample_rate)
+	sineW(float _freq = 440, int _seconds = 1, unsigned int _sample_rate = 22050, bool generateBuffer = true, Waveform _wave = WAVE_SINE)
+		: freq(_freq), actualFreq(_freq), seconds(_seconds), sample_rate(_sample_rate), wave(_wave), buf_size(0)
 	{
-		alGenBuffers(1, &bufferid);
-		alGenSources(1, &sourceid);
+		//recycled from the global pools, see ALPool.h
+		bufferid = bufferPool().acquire();
+		sourceid = sourcePool().acquire();
 
-		buf_size = seconds * sample_rate;
 		//user may want to not create this now
-		if(generateBuffer){
-			samples = new short[buf_size];
-			//populate sample buffer
-			for (int i = 0; i < buf_size; ++i)
-				//samples[i] = 32768 * 2 * (i * freq - int((i * freq) + 0.5)) / sample_rate;		//sawtooth - does not work
-				//samples[i] = 32768 * (2/M_PI) * asin(sin((2 * M_PI * freq * i) / sample_rate));	//triangle
-				//samples[i] = 32768 * sgn(cos((2 * M_PI * freq * i) / sample_rate));				//square
-				samples[i] = 32768 * cos((2 * M_PI * freq * i) / sample_rate);					//sin or cos
-			// 32760 because we use mono16, and 16 bits is 32768 (ignoring last digit cuz lazy)
-			samples[0] = samples[buf_size - 1]; //i=0 causes issues, set it to one previous
-
-			/* Download buffer to OpenAL ---- don't do this immediately, user may want to do it later! */
-			alBufferData(bufferid, AL_FORMAT_MONO16, samples, buf_size, sample_rate);
-		}
-		//alSourcei(sourceid, AL_BUFFER, bufferid);
+		if (generateBuffer)
+			generate();
 	}
 
-	short* sineSegment(float seconds, int segmentStart, unsigned int _sample_rate){
-		short* samplesSegment = new short[int(seconds * _sample_rate)];
+	//the AL objects are owned too, so copies would release them twice
+	sineW(const sineW&) = delete;
+	sineW& operator=(const sineW&) = delete;
 
-		for (int i = 0; i < int(seconds * _sample_rate); ++i)
-			samplesSegment[i] = 32768 * cos((2 * M_PI * freq * (int(seconds * _sample_rate) +i)) / sample_rate);	//sin or cos
-		samplesSegment[0] = samplesSegment[int(seconds * _sample_rate) - 1]; //i=0 causes issues, set it to one previous
-	
-		return samplesSegment;
+	~sineW() {
+		if (poolsReady())
+			release();
 	}
 
-	/*~sineW() {
-		alDeleteSources(1, &sourceid);
-		alDeleteBuffers(1, &bufferid);
-		delete[] samples;
-	}*/
+	//fills the looping buffer and downloads it to OpenAL
+	void generate();
+	//attaches the buffer and starts it looping
+	void play();
+
+	//hands the source and buffer back to the global pools. Safe to call more than once
+	void release() {
+		if (sourceid != 0)
+			sourcePool().release(sourceid); //source first, it may still have the buffer attached
+		if (bufferid != 0)
+			bufferPool().release(bufferid);
+		sourceid = 0;
+		bufferid = 0;
+	}
 };
 #pragma endregion structs
 
@@ -119,9 +148,13 @@ void deleteSoundFiles(std::vector<soundFile*> &soundFiles);
 //utilities
 void getAudioFormat(int channel, int bps, unsigned int& format);
 void initAudioSource(soundFile& sFile);
-void keyInput(bool& running, float speed, float sensitivity, Listener& player, std::vector<soundFile*>& sounds);
-soundFile createSoundFile(std::string fileName);
-std::vector<soundFile*> createSounds(std::vector<std::string>& files);
+void playSound(soundFile& sFile);
+void stopSound(soundFile& sFile);
+void setSoundLooping(soundFile& sFile, bool looping);
+//keys [1-9] play the sound files first, then the procedural sources
+void keyInput(bool& running, float speed, float sensitivity, Listener& player, std::vector<soundFile*>& sounds, std::vector<ProceduralSource*>* procedurals = NULL);
+soundFile createSoundFile(std::string fileName, LoadMode mode = LOAD_COPY);
+std::vector<soundFile*> createSounds(std::vector<std::string>& files, LoadMode mode = LOAD_COPY);
 void setListenerAngle(float angle, Listener& player);
 void moveListener(glm::vec3 position, Listener& player);
 #pragma endregion prototypes
@@ -130,108 +163,4 @@ class ALUtilities
 {
 
 };
-
-/////////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////  Ray Tracing Code  //////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////////////////////////////////
-
-class Ray{
-private:
-	glm::vec3 origin;    // M
-	glm::vec3 direction; // n, must be a unit vector
-public:
-	Ray() {};
-	Ray(glm::vec3 orig, glm::vec3 dir) : origin(orig), direction(dir) {}
-	//~Ray() {}
-	const glm::vec3& getOrig() const { return origin; }
-	const glm::vec3& getDir() const { return direction; } // if you don't init get functions like this, accessing this method from const reference objects would be impossible
-	void setOrig(glm::vec3 _origin) { origin = _origin; }
-	void setDir(glm::vec3 _direction) { direction = _direction; }
-
-	// calculates M + nx -- returns vector length between origin and a point
-	glm::vec3 at(float x) const	{ return (origin + (direction * x)); }
-};
-
-struct Material {
-	float	notAbsorbed;		// absorption modifier (ranges from 0.0 to 1.0)
-	bool	isSource = false;	//is this a sound source?
-	//may also have a scatter modifier (how much randomization to add to reflection) -> not sure if necessary
-
-	Material(float _absorbModifier = 0.4) : notAbsorbed(_absorbModifier) {}
-
-	float soundDampenPercent() { return notAbsorbed; }
-};
-
-struct Sphere {
-	glm::vec3	center;
-	float		radius;
-	Material	mtl;
-
-	Sphere() : center(glm::vec3(0, 0, 0)), radius(2) {}; // default sphere at origin with radius 2
-	Sphere(glm::vec3 _center, float	_radius) : center(_center), radius(_radius) {}; // sphere at given center with given radius
-	Sphere(glm::vec3 _center, float	_radius, bool _isSource) : center(_center), radius(_radius) { mtl.isSource = _isSource; }; // source sphere at given center with given radius
-};
-
-struct Triangle {
-	glm::vec3 v0, v1, v2;
-	Material mtl;
-
-	Triangle() : v0(glm::vec3(1, 0, 0)), v1(glm::vec3(0, 0, 0)), v2(glm::vec3(0, 0, 1)) {}; // default triangle
-	Triangle(glm::vec3 _v0, glm::vec3 _v1, glm::vec3 _v2) : v0(_v0), v1(_v1), v2(_v2) {}; // triangle with given vertices
-
-	//TODO: Maybe also have a second check for double sided triangles
-	// ie. getNormal() returns the normal of the triangle, but if the ray hits the back side, it should return the negative of the normal
-	glm::vec3 getNormal() {
-		glm::vec3 edge1 = v1 - v0;
-		glm::vec3 edge2 = v2 - v0;
-		return glm::normalize(glm::cross(edge1, edge2));
-	}
-};
-
-//struct Light { //for me this is sound
-//	vec3 position;
-//	vec3 intensity;
-//};
-
-struct HitInfo {
-	float		t; //closest hit distance
-	glm::vec3	position;
-	glm::vec3	normal;
-	Material	mtl;
-};
-
-struct reflectInfo {
-	sineW sound = sineW(440, 1, 22050, false);
-	HitInfo hit;
-	float totalAbsorbed; // multiply with original sound source to get dampened sound (reduced amplitude)
-
-	reflectInfo(HitInfo _hit) : hit(_hit) { totalAbsorbed = hit.mtl.soundDampenPercent(); }
-	reflectInfo(HitInfo _hit, float prevDampen) : hit(_hit) { totalAbsorbed = prevDampen * _hit.mtl.soundDampenPercent(); }
-};
-
-//const int NUM_SPHERES = 1; //ideally we want this to be however many surfaces there are in the scene
-//int MAX_BOUNCES = 3;
-//Sphere spheres[NUM_SPHERES]; //number of objects
-//uniform Light  lights[NUM_LIGHTS]; //number of sound sources
-//uniform samplerCube envMap; //pretty sure this is just a cube map
-//int bounceLimit = 3; //don't understand why this is needed?
-
-//Reverses the calculated order of reflection absorptions
-void ReverseAbsorptionOrder(std::vector<reflectInfo>& reflectedSources);
-
-// Intersects the given ray with all spheres in the scene
-// and updates the given HitInfo using the information of the sphere
-// that first intersects with the ray.
-// Returns true if an intersection is found.
-bool IntersectRaySphere(HitInfo& hit, Ray ray);
-
-
-//TODO: modify this. It only computes light rendering at a point. But we can hear places we cannot see. We need to return sound sources at all intersection points
-// Given a ray, returns the sound where the ray intersects a sphere.
-// If the ray does not hit a sphere, returns nothing.
-std::vector<reflectInfo> RayTracer(Ray ray);
-
-float get_random();
-
-Ray GetRandomRay(Listener listener);
 #endif
\ No newline at end of file
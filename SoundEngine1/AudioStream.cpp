@@ -0,0 +1,205 @@
+#include "AudioStream.h"
+#include "ALUtilities.h"
+
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#pragma region reader
+//all streams serviced by the background reader
+static std::vector<wavStream*> activeStreams;
+static std::mutex streamsLock;
+static std::thread readerThread;
+static std::atomic<bool> readerRunning{ false };
+
+/**
+ * reads the next chunk of sample data into the given buffer
+ * wraps around to the start of the data if the stream loops
+ * returns false if there was nothing left to read
+ */
+static bool fillStreamBuffer(wavStream* stream, unsigned int bufferid) {
+	int filled = 0;
+
+	while (filled < STREAM_CHUNK_SIZE) {
+		if (stream->dataRead >= stream->dataSize) {
+			if (!stream->looping || stream->dataSize == 0)
+				break;
+			stream->file.clear();
+			stream->file.seekg(stream->dataStart);
+			stream->dataRead = 0;
+		}
+
+		int toRead = std::min(STREAM_CHUNK_SIZE - filled, stream->dataSize - stream->dataRead);
+		stream->file.read(stream->chunk + filled, toRead);
+		int got = (int)stream->file.gcount();
+		if (got <= 0) { // file is shorter than its header claims
+			stream->dataSize = stream->dataRead;
+			continue;
+		}
+
+		filled += got;
+		stream->dataRead += got;
+	}
+
+	if (filled == 0)
+		return false;
+
+	alBufferData(bufferid, stream->format, stream->chunk, filled, stream->sampleRate);
+	return true;
+}
+
+//refills every processed buffer of one stream and restarts it if it ran dry
+static void serviceStream(wavStream* stream) {
+	std::lock_guard<std::mutex> guard(stream->lock);
+	if (!stream->playing)
+		return;
+
+	int processed = 0;
+	alGetSourcei(stream->sourceid, AL_BUFFERS_PROCESSED, &processed);
+	while (processed-- > 0) {
+		unsigned int bufferid;
+		alSourceUnqueueBuffers(stream->sourceid, 1, &bufferid);
+		if (fillStreamBuffer(stream, bufferid))
+			alSourceQueueBuffers(stream->sourceid, 1, &bufferid);
+	}
+
+	int queued = 0, state = 0;
+	alGetSourcei(stream->sourceid, AL_BUFFERS_QUEUED, &queued);
+	alGetSourcei(stream->sourceid, AL_SOURCE_STATE, &state);
+	if (queued == 0)
+		stream->playing = false;	// end of the file reached and fully played
+	else if (state != AL_PLAYING && state != AL_PAUSED)
+		alSourcePlay(stream->sourceid);	// the reader fell behind and the source starved
+}
+
+static void readerLoop() {
+	while (readerRunning) {
+		{
+			std::lock_guard<std::mutex> guard(streamsLock);
+			for (int i = 0; i < activeStreams.size(); i++)
+				serviceStream(activeStreams[i]);
+		}
+		// one 64 KB buffer of 44.1 kHz stereo16 lasts ~370 ms, so this leaves plenty of headroom
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+#pragma endregion reader
+
+/**
+ * opens a WAV file for streaming
+ * walks the RIFF chunks to find the format and the start of the sample data
+ */
+wavStream* openStream(std::string filename, int& channel, int& sampleRate, int& bps, int& size) {
+	wavStream* stream = new wavStream();
+	stream->name = filename;
+	stream->file.open(filename, std::ios::binary);
+
+	char header[12];
+	stream->file.read(header, 12);
+	if (!stream->file || strncmp(header, "RIFF", 4) != 0 || strncmp(header + 8, "WAVE", 4) != 0) {
+		std::cout << "WAV file does not use RIFF/WAVE: " << filename << std::endl;
+		delete stream;
+		return NULL;
+	}
+
+	bool foundFormat = false;
+	char chunkHeader[8];
+	while (stream->file.read(chunkHeader, 8)) {
+		unsigned int chunkSize = (unsigned int)charToInt(chunkHeader + 4, 4);
+
+		if (strncmp(chunkHeader, "fmt ", 4) == 0 && chunkSize >= 16) {
+			char fmt[16];
+			stream->file.read(fmt, 16);
+			channel = charToInt(fmt + 2, 2);
+			sampleRate = charToInt(fmt + 4, 4);
+			bps = charToInt(fmt + 14, 2);
+			foundFormat = true;
+			stream->file.seekg(chunkSize - 16 + (chunkSize & 1), std::ios::cur);
+		}
+		else if (strncmp(chunkHeader, "data", 4) == 0) {
+			stream->dataStart = stream->file.tellg();
+			stream->dataSize = (int)chunkSize;
+			break;
+		}
+		else
+			stream->file.seekg(chunkSize + (chunkSize & 1), std::ios::cur);
+	}
+
+	if (!foundFormat || stream->dataStart == 0) {
+		std::cout << "WAV file is missing its fmt or data chunk: " << filename << std::endl;
+		delete stream;
+		return NULL;
+	}
+
+	size = stream->dataSize;
+	stream->sampleRate = sampleRate;
+	getAudioFormat(channel, bps, stream->format);
+	stream->chunk = new char[STREAM_CHUNK_SIZE];
+
+	printf("%s successfully opened for streaming\nchannel: %i; sample rate: %i; bits per second: %i, audio size: %i\n", filename.c_str(), channel, sampleRate, bps, size);
+	return stream;
+}
+
+void startStream(wavStream* stream, unsigned int sourceid) {
+	stream->sourceid = sourceid;
+	alGenBuffers(STREAM_BUFFER_COUNT, stream->buffers);
+
+	std::lock_guard<std::mutex> guard(streamsLock);
+	activeStreams.push_back(stream);
+	if (!readerRunning) {
+		readerRunning = true;
+		readerThread = std::thread(readerLoop);
+	}
+}
+
+void playStream(wavStream* stream) {
+	std::lock_guard<std::mutex> guard(stream->lock);
+
+	//drop whatever is still queued and start over from the first sample
+	alSourceStop(stream->sourceid);
+	alSourcei(stream->sourceid, AL_BUFFER, 0);
+	stream->file.clear();
+	stream->file.seekg(stream->dataStart);
+	stream->dataRead = 0;
+
+	int queued = 0;
+	for (int i = 0; i < STREAM_BUFFER_COUNT; i++) {
+		if (!fillStreamBuffer(stream, stream->buffers[i]))
+			break;
+		queued++;
+	}
+	if (queued == 0)
+		return;
+
+	alSourceQueueBuffers(stream->sourceid, queued, stream->buffers);
+	alSourcePlay(stream->sourceid);
+	stream->playing = true;
+}
+
+void stopStream(wavStream* stream) {
+	std::lock_guard<std::mutex> guard(stream->lock);
+	stream->playing = false;
+	alSourceStop(stream->sourceid);
+}
+
+void closeStream(wavStream* stream) {
+	bool lastStream = false;
+	{
+		std::lock_guard<std::mutex> guard(streamsLock);
+		activeStreams.erase(std::remove(activeStreams.begin(), activeStreams.end(), stream), activeStreams.end());
+		lastStream = activeStreams.empty();
+	}
+	if (lastStream && readerRunning) {
+		readerRunning = false;
+		readerThread.join();
+	}
+
+	if (stream->sourceid != 0) {
+		alSourceStop(stream->sourceid);
+		alSourcei(stream->sourceid, AL_BUFFER, 0);
+		alDeleteBuffers(STREAM_BUFFER_COUNT, stream->buffers);
+	}
+
+	delete[] stream->chunk;
+	delete stream;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef AUDIOSTREAM
+#define AUDIOSTREAM
+#include <fstream>
+#include <string>
+#include <mutex>
+#include <atomic>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+
+// resident memory per stream is STREAM_BUFFER_COUNT * STREAM_CHUNK_SIZE in OpenAL
+// plus one STREAM_CHUNK_SIZE staging block, regardless of the file length
+#define STREAM_BUFFER_COUNT 4
+#define STREAM_CHUNK_SIZE (64 * 1024)
+
+/**
+ * WAV file played through a small ring of queued OpenAL buffers
+ * processed buffers are refilled from disk by a shared background reader thread
+ */
+struct wavStream {
+	std::string name;
+	std::ifstream file;
+	std::streamoff dataStart = 0;	// file offset of the first sample
+	int dataSize = 0;				// bytes of sample data in the file
+	int dataRead = 0;				// bytes of sample data consumed so far
+
+	unsigned int format = 0;
+	int sampleRate = 0;
+	unsigned int sourceid = 0;
+	unsigned int buffers[STREAM_BUFFER_COUNT] = {};
+	char* chunk = NULL;				// staging block, STREAM_CHUNK_SIZE bytes
+
+	std::atomic<bool> looping{ false };	// rewind at the end of the file instead of stopping
+	bool playing = false;			// the reader keeps the queue topped up while this is set
+	std::mutex lock;				// guards the file and all AL calls on sourceid
+};
+
+// opens a WAV file for streaming and reads its header. Returns NULL on failure
+wavStream* openStream(std::string filename, int& channel, int& sampleRate, int& bps, int& size);
+// creates the buffer ring for the given source and registers the stream with the background reader
+void startStream(wavStream* stream, unsigned int sourceid);
+// rewinds the stream, fills the whole ring and starts playback
+void playStream(wavStream* stream);
+void stopStream(wavStream* stream);
+// unregisters the stream, deletes its buffers and closes the file. The source is left to the caller
+void closeStream(wavStream* stream);
+#endif
@@ -0,0 +1,352 @@
+#include "BVH.h"
+#include "RayTracer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <float.h>
+
+struct BVHBin {
+	glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+	glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+	int count = 0;
+};
+
+static float halfArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+	glm::vec3 e = boundsMax - boundsMin;
+	return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+//large ranges are split over the shared pool, a few chunks per worker
+static int chunksFor(int count) {
+	return count >= BVH_PARALLEL_THRESHOLD ? sharedPool().size() * 4 : 1;
+}
+
+//runs task(begin, end, chunk) over [first, first + count) in the given number of chunks
+template <typename F> static void forChunks(int first, int count, int chunks, F task) {
+	if (chunks <= 1) {
+		task(first, first + count, 0);
+		return;
+	}
+	sharedPool().parallelFor(chunks, [&](int c) {
+		task(first + (int)((long long)count * c / chunks), first + (int)((long long)count * (c + 1) / chunks), c);
+	});
+}
+
+void BVH::build(const Scene& scene) {
+	const std::vector<Sphere>& spheres = scene.getSpheres();
+	const TriangleStore& triangles = scene.getTriangles();
+	int sphereCount = (int)spheres.size();
+	int count = sphereCount + (int)triangles.size();
+
+	nodes.clear();
+	prims.resize(count);
+	if (count == 0)
+		return;
+
+	//bounds of every primitive, spheres first
+	primMin.resize(count);
+	primMax.resize(count);
+	centroids.resize(count);
+	forChunks(0, count, chunksFor(count), [&](int begin, int end, int) {
+		for (int i = begin; i < end; i++) {
+			if (i < sphereCount) {
+				const Sphere& s = spheres[i];
+				primMin[i] = s.center - glm::vec3(s.radius);
+				primMax[i] = s.center + glm::vec3(s.radius);
+			}
+			else {
+				int t = i - sphereCount;
+				glm::vec3 v0 = triangles.vertex0(t), v1 = v0 + triangles.edge1(t), v2 = v0 + triangles.edge2(t);
+				primMin[i] = glm::min(v0, glm::min(v1, v2));
+				primMax[i] = glm::max(v0, glm::max(v1, v2));
+			}
+			centroids[i] = (primMin[i] + primMax[i]) * 0.5f;
+			prims[i] = i;
+		}
+	});
+
+	nodes.reserve(2 * count - 1); // upper bound for a binary tree with count leaves
+	BVHNode root;
+	root.leftFirst = 0;
+	root.count = count;
+	nodes.push_back(root);
+	updateBounds(0);
+	subdivide(0, 0);
+
+	//swap build indices for primitive references
+	for (int i = 0; i < count; i++)
+		prims[i] = prims[i] < (unsigned int)sphereCount ? (prims[i] | BVH_SPHERE_BIT) : prims[i] - sphereCount;
+	packLeaves(scene);
+
+	primMin.clear(); primMin.shrink_to_fit();
+	primMax.clear(); primMax.shrink_to_fit();
+	centroids.clear(); centroids.shrink_to_fit();
+}
+
+void BVH::updateBounds(int nodeIndex) {
+	BVHNode& node = nodes[nodeIndex];
+	int chunks = chunksFor(node.count);
+	std::vector<BVHBin> partial(chunks);
+
+	forChunks(node.leftFirst, node.count, chunks, [&](int begin, int end, int c) {
+		BVHBin& b = partial[c];
+		for (int i = begin; i < end; i++) {
+			b.boundsMin = glm::min(b.boundsMin, primMin[prims[i]]);
+			b.boundsMax = glm::max(b.boundsMax, primMax[prims[i]]);
+		}
+	});
+
+	node.boundsMin = partial[0].boundsMin;
+	node.boundsMax = partial[0].boundsMax;
+	for (int c = 1; c < chunks; c++) {
+		node.boundsMin = glm::min(node.boundsMin, partial[c].boundsMin);
+		node.boundsMax = glm::max(node.boundsMax, partial[c].boundsMax);
+	}
+}
+
+void BVH::subdivide(int nodeIndex, int depth) {
+	int first = nodes[nodeIndex].leftFirst;
+	int count = nodes[nodeIndex].count;
+	if (count <= 1 || depth >= BVH_MAX_DEPTH - 2)
+		return;
+
+	//bins are laid out over the centroid bounds, not the primitive bounds
+	int chunks = chunksFor(count);
+	std::vector<BVHBin> centroidBounds(chunks);
+	forChunks(first, count, chunks, [&](int begin, int end, int c) {
+		for (int i = begin; i < end; i++) {
+			centroidBounds[c].boundsMin = glm::min(centroidBounds[c].boundsMin, centroids[prims[i]]);
+			centroidBounds[c].boundsMax = glm::max(centroidBounds[c].boundsMax, centroids[prims[i]]);
+		}
+	});
+	glm::vec3 cMin = centroidBounds[0].boundsMin, cMax = centroidBounds[0].boundsMax;
+	for (int c = 1; c < chunks; c++) {
+		cMin = glm::min(cMin, centroidBounds[c].boundsMin);
+		cMax = glm::max(cMax, centroidBounds[c].boundsMax);
+	}
+	glm::vec3 extent = cMax - cMin;
+	glm::vec3 scale;
+	for (int a = 0; a < 3; a++)
+		scale[a] = extent[a] > 0 ? BVH_BINS / extent[a] : 0;
+
+	//every primitive goes into one bin per axis; large nodes bin per chunk and merge
+	std::vector<BVHBin> chunkBins(chunks * 3 * BVH_BINS);
+	forChunks(first, count, chunks, [&](int begin, int end, int c) {
+		BVHBin* bins = &chunkBins[c * 3 * BVH_BINS];
+		for (int i = begin; i < end; i++) {
+			unsigned int p = prims[i];
+			for (int a = 0; a < 3; a++) {
+				int b = std::min(BVH_BINS - 1, (int)((centroids[p][a] - cMin[a]) * scale[a]));
+				BVHBin& bin = bins[a * BVH_BINS + b];
+				bin.count++;
+				bin.boundsMin = glm::min(bin.boundsMin, primMin[p]);
+				bin.boundsMax = glm::max(bin.boundsMax, primMax[p]);
+			}
+		}
+	});
+	BVHBin bins[3][BVH_BINS];
+	for (int c = 0; c < chunks; c++) {
+		for (int a = 0; a < 3; a++) {
+			for (int b = 0; b < BVH_BINS; b++) {
+				const BVHBin& from = chunkBins[(c * 3 + a) * BVH_BINS + b];
+				bins[a][b].count += from.count;
+				bins[a][b].boundsMin = glm::min(bins[a][b].boundsMin, from.boundsMin);
+				bins[a][b].boundsMax = glm::max(bins[a][b].boundsMax, from.boundsMax);
+			}
+		}
+	}
+
+	//sweep the split planes between the bins from both sides: cost = area * primitives on each side
+	float bestCost = FLT_MAX;
+	int bestAxis = -1, bestSplit = 0;
+	for (int a = 0; a < 3; a++) {
+		if (scale[a] == 0)
+			continue;
+
+		float leftArea[BVH_BINS - 1], rightArea[BVH_BINS - 1];
+		int leftCount[BVH_BINS - 1], rightCount[BVH_BINS - 1];
+		BVHBin left, right;
+		for (int i = 0; i < BVH_BINS - 1; i++) {
+			left.count += bins[a][i].count;
+			left.boundsMin = glm::min(left.boundsMin, bins[a][i].boundsMin);
+			left.boundsMax = glm::max(left.boundsMax, bins[a][i].boundsMax);
+			leftCount[i] = left.count;
+			leftArea[i] = left.count > 0 ? halfArea(left.boundsMin, left.boundsMax) : 0;
+
+			const BVHBin& r = bins[a][BVH_BINS - 1 - i];
+			right.count += r.count;
+			right.boundsMin = glm::min(right.boundsMin, r.boundsMin);
+			right.boundsMax = glm::max(right.boundsMax, r.boundsMax);
+			rightCount[BVH_BINS - 2 - i] = right.count;
+			rightArea[BVH_BINS - 2 - i] = right.count > 0 ? halfArea(right.boundsMin, right.boundsMax) : 0;
+		}
+		for (int i = 0; i < BVH_BINS - 1; i++) {
+			if (leftCount[i] == 0 || rightCount[i] == 0)
+				continue;
+			float cost = leftArea[i] * leftCount[i] + rightArea[i] * rightCount[i];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = a;
+				bestSplit = i + 1; // bins [0, bestSplit) go left
+			}
+		}
+	}
+
+	//a leaf is cheaper unless it would get too large
+	float nodeArea = halfArea(nodes[nodeIndex].boundsMin, nodes[nodeIndex].boundsMax);
+	float leafCost = nodeArea * count;
+	bestCost += nodeArea * BVH_TRAVERSAL_COST;
+	if (bestAxis < 0 || (bestCost >= leafCost && count <= BVH_MAX_LEAF))
+		return;
+
+	float axisMin = cMin[bestAxis], axisScale = scale[bestAxis];
+	unsigned int* middle = std::partition(prims.data() + first, prims.data() + first + count, [&](unsigned int p) {
+		return std::min(BVH_BINS - 1, (int)((centroids[p][bestAxis] - axisMin) * axisScale)) < bestSplit;
+	});
+	int leftCount = (int)(middle - (prims.data() + first));
+	if (leftCount == 0 || leftCount == count)
+		return;
+
+	int leftChild = (int)nodes.size();
+	BVHNode child;
+	child.leftFirst = first;
+	child.count = leftCount;
+	nodes.push_back(child);
+	child.leftFirst = first + leftCount;
+	child.count = count - leftCount;
+	nodes.push_back(child);
+
+	nodes[nodeIndex].leftFirst = leftChild;
+	nodes[nodeIndex].count = 0;
+
+	updateBounds(leftChild);
+	updateBounds(leftChild + 1);
+	subdivide(leftChild, depth + 1);
+	subdivide(leftChild + 1, depth + 1);
+}
+
+//sorts the spheres of every leaf to its front and copies all primitives into the kernel arrays
+void BVH::packLeaves(const Scene& scene) {
+	const std::vector<Sphere>& spheres = scene.getSpheres();
+	const TriangleStore& triangles = scene.getTriangles();
+	int count = (int)prims.size();
+
+	for (int n = 0; n < nodes.size(); n++) {
+		if (nodes[n].count > 0) {
+			unsigned int* leafFirst = prims.data() + nodes[n].leftFirst;
+			std::partition(leafFirst, leafFirst + nodes[n].count, [](unsigned int p) { return (p & BVH_SPHERE_BIT) != 0; });
+		}
+	}
+
+	leafTriangles.clear();
+	for (int k = 0; k < 4; k++)
+		sphereData[k].assign(count + RAY_KERNEL_PAD, 0.0f);
+
+	for (int i = 0; i < count; i++) {
+		if (prims[i] & BVH_SPHERE_BIT) {
+			const Sphere& s = spheres[prims[i] & ~BVH_SPHERE_BIT];
+			for (int k = 0; k < 3; k++)
+				sphereData[k][i] = s.center[k];
+			sphereData[3][i] = s.radius;
+			leafTriangles.add(Triangle(glm::vec3(0), glm::vec3(0), glm::vec3(0))); // never hit
+		}
+		else
+			leafTriangles.add(triangles, prims[i]);
+	}
+}
+
+//entry distance of the ray into the box, FLT_MAX if it misses or only enters beyond maxT
+static inline float slabTest(const BVHNode& node, const glm::vec3& origin, const glm::vec3& invDir, float maxT) {
+	float tx1 = (node.boundsMin.x - origin.x) * invDir.x, tx2 = (node.boundsMax.x - origin.x) * invDir.x;
+	float tmin = std::min(tx1, tx2), tmax = std::max(tx1, tx2);
+	float ty1 = (node.boundsMin.y - origin.y) * invDir.y, ty2 = (node.boundsMax.y - origin.y) * invDir.y;
+	tmin = std::max(tmin, std::min(ty1, ty2)), tmax = std::min(tmax, std::max(ty1, ty2));
+	float tz1 = (node.boundsMin.z - origin.z) * invDir.z, tz2 = (node.boundsMax.z - origin.z) * invDir.z;
+	tmin = std::max(tmin, std::min(tz1, tz2)), tmax = std::min(tmax, std::max(tz1, tz2));
+
+	if (tmax >= std::max(tmin, 0.0f) && tmin < maxT)
+		return tmin;
+	return FLT_MAX;
+}
+
+bool BVH::intersect(const Scene& scene, HitInfo& hit, const Ray& ray) const {
+	hit.t = 1e30;
+	if (nodes.empty())
+		return false;
+
+	glm::vec3 origin = ray.getOrig();
+	glm::vec3 invDir = 1.0f / ray.getDir();
+	const RayKernels& kernels = rayKernels();
+	KernelRay kernelRay = { origin.x, origin.y, origin.z, ray.getDir().x, ray.getDir().y, ray.getDir().z, glm::dot(ray.getDir(), ray.getDir()) };
+	//taken from the vectors on every call, so a copied BVH never points into another one's arrays
+	SphereSoA sphereSoA = { { sphereData[0].data(), sphereData[1].data(), sphereData[2].data() }, sphereData[3].data() };
+
+	float bestT = 1e30f;
+	unsigned int bestPrim = 0;
+	bool foundHit = false;
+
+	int stack[BVH_MAX_DEPTH];
+	float stackDist[BVH_MAX_DEPTH];
+	int stackSize = 0;
+
+	if (slabTest(nodes[0], origin, invDir, bestT) == FLT_MAX)
+		return false;
+	int nodeIndex = 0;
+
+	while (true) {
+		const BVHNode& node = nodes[nodeIndex];
+		if (node.count > 0) {
+			//spheres are sorted to the front of each leaf, and are rare, so this usually stops at once
+			int sphereCount = 0;
+			while (sphereCount < node.count && (prims[node.leftFirst + sphereCount] & BVH_SPHERE_BIT))
+				sphereCount++;
+
+			int closest = -1;
+			if (sphereCount > 0) {
+				int i = kernels.spheres(kernelRay, sphereSoA, node.leftFirst, sphereCount, bestT);
+				if (i >= 0) closest = i;
+			}
+			if (sphereCount < node.count) {
+				int i = kernels.triangles(kernelRay, leafTriangles.arrays(), node.leftFirst + sphereCount, node.count - sphereCount, bestT);
+				if (i >= 0) closest = i;
+			}
+			if (closest >= 0) {
+				bestPrim = prims[closest];
+				foundHit = true;
+			}
+		}
+		else {
+			//visit the nearer child first, the farther one waits on the stack
+			int near = node.leftFirst, far = node.leftFirst + 1;
+			float nearDist = slabTest(nodes[near], origin, invDir, bestT);
+			float farDist = slabTest(nodes[far], origin, invDir, bestT);
+			if (farDist < nearDist) {
+				std::swap(near, far);
+				std::swap(nearDist, farDist);
+			}
+			if (nearDist != FLT_MAX) {
+				if (farDist != FLT_MAX) {
+					stack[stackSize] = far;
+					stackDist[stackSize++] = farDist;
+				}
+				nodeIndex = near;
+				continue;
+			}
+		}
+
+		//pop the next node that can still hold a closer hit
+		do {
+			if (stackSize == 0) {
+				if (foundHit) {
+					if (bestPrim & BVH_SPHERE_BIT)
+						SetSphereHit(scene, bestPrim & ~BVH_SPHERE_BIT, ray, bestT, hit);
+					else
+						SetTriangleHit(scene, bestPrim, ray, bestT, hit);
+				}
+				return foundHit;
+			}
+			stackSize--;
+		} while (stackDist[stackSize] >= bestT);
+		nodeIndex = stack[stackSize];
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef BVH_H
+#define BVH_H
+#include <vector>
+
+#include <glm.hpp>
+
+#include "RayKernels.h"
+#include "TriangleStore.h"
+
+class Scene;
+class Ray;
+struct HitInfo;
+
+// primitive references: the index into Scene::getTriangles(), or into getSpheres() with this bit set
+#define BVH_SPHERE_BIT 0x80000000u
+// split candidates per axis tried by the binned SAH
+#define BVH_BINS 16
+// cost of visiting a node relative to testing one primitive
+#define BVH_TRAVERSAL_COST 1.0f
+// leaves never hold more than this, unless every centroid in them is the same point
+#define BVH_MAX_LEAF 8
+// nodes with at least this many primitives are binned on the shared thread pool
+#define BVH_PARALLEL_THRESHOLD (64 * 1024)
+// smaller scenes are traced by brute force through the SIMD kernels even with a BVH built
+#define BVH_MIN_PRIMITIVES 512
+// traversal stack size, the build stops splitting before this depth
+#define BVH_MAX_DEPTH 64
+
+// 32 bytes, two nodes per cache line
+struct BVHNode {
+	glm::vec3 boundsMin;
+	int leftFirst;	// first primitive of a leaf, or the left child (the right one follows it)
+	glm::vec3 boundsMax;
+	int count;		// primitives in a leaf, 0 for inner nodes
+};
+
+/**
+ * bounding volume hierarchy over every sphere and triangle of a Scene
+ * built top down with a binned surface area heuristic; traversal is stack based,
+ * nearest child first, and skips any node farther away than the closest hit so far
+ * leaves are tested with the widest ray kernels the CPU supports (see RayKernels.h)
+ */
+class BVH {
+private:
+	std::vector<BVHNode> nodes;
+	std::vector<unsigned int> prims;	// primitive references, leaves point at contiguous runs, spheres first
+
+	// copies of the primitives in prims order for the SIMD kernels, padded by RAY_KERNEL_PAD
+	TriangleStore leafTriangles;		// degenerate where prims holds a sphere
+	std::vector<float> sphereData[4];	// center xyz, radius; unused where prims holds a triangle
+
+	// build only: bounds and centroid of each primitive, prims holds indices into these until the build ends
+	std::vector<glm::vec3> primMin, primMax, centroids;
+
+	void updateBounds(int nodeIndex);
+	void subdivide(int nodeIndex, int depth);
+	void packLeaves(const Scene& scene);
+public:
+	void build(const Scene& scene);
+	// closest hit, same result as testing every primitive
+	bool intersect(const Scene& scene, HitInfo& hit, const Ray& ray) const;
+
+	bool empty() const { return nodes.empty(); }
+	int nodeCount() const { return (int)nodes.size(); }
+};
+#endif
@@ -0,0 +1,584 @@
+#include "Benchmarks.h"
+#include "Oscillators.h"
+#include "Wavetable.h"
+#include "Noise.h"
+#include "RayTracer.h"
+#include "RayKernels.h"
+#include "ThreadPool.h"
+#include "RaySampling.h"
+#include "ImageSource.h"
+#include "TemporalPaths.h"
+#include "Echogram.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <set>
+
+typedef std::chrono::steady_clock benchClock;
+
+static double secondsSince(benchClock::time_point start) {
+	return std::chrono::duration<double>(benchClock::now() - start).count();
+}
+
+void benchmarkOscillators() {
+	const int blockSize = 4410;	// 0.2 s segment at 22050 Hz, what the playBit region generates
+	const int blocks = 2000;
+	const float freq = 440;
+	const unsigned int sampleRate = 22050;
+	const double pi = 3.14159265358979323846;
+	std::vector<short> block(blockSize);
+	long long checksum = 0; // keeps the compiler from dropping the loops
+
+	//the old sineW/sineSegment approach: one libm cos() per sample
+	benchClock::time_point start = benchClock::now();
+	for (int b = 0; b < blocks; b++) {
+		for (int i = 0; i < blockSize; ++i)
+			block[i] = 32767 * cos((2 * pi * freq * (b * blockSize + i)) / sampleRate);
+		checksum += block[blockSize / 2];
+	}
+	double libmSeconds = secondsSince(start);
+
+	SineOscillator osc(freq, sampleRate);
+	start = benchClock::now();
+	for (int b = 0; b < blocks; b++) {
+		osc.fill(block.data(), blockSize);
+		checksum += block[blockSize / 2];
+	}
+	double oscSeconds = secondsSince(start);
+
+	double samples = double(blockSize) * blocks;
+	printf("oscillator benchmark (%i blocks of %i samples)\n", blocks, blockSize);
+	printf("\tcos() per sample: %8.1f Msamples/s\n", samples / libmSeconds / 1e6);
+	printf("\tSineOscillator:   %8.1f Msamples/s (%.1fx)\n", samples / oscSeconds / 1e6, libmSeconds / oscSeconds);
+	printf("\t(checksum %lld)\n", checksum);
+}
+
+void benchmarkWavetables() {
+	const int oscillators = 256;
+	const int blockSize = 1024;
+	const int blocks = 200;
+	const unsigned int sampleRate = 44100;
+	const double pi = 3.14159265358979323846;
+	std::vector<float> block(blockSize);
+	double checksum = 0;
+
+	//the formulas sineW had (commented out) for its waveforms, one libm call chain per sample
+	benchClock::time_point start = benchClock::now();
+	for (int o = 0; o < oscillators; o++) {
+		double freq = 110 + o * 7.3;
+		int wave = o % 4;
+		for (int b = 0; b < blocks / 4; b++) { // a quarter of the work, the libm path is slow
+			for (int i = 0; i < blockSize; i++) {
+				double x = (2 * pi * freq * (b * blockSize + i)) / sampleRate;
+				float v;
+				if (wave == 0) v = (float)cos(x);
+				else if (wave == 1) v = (float)((2 / pi) * asin(sin(x)));
+				else if (wave == 2) v = (float)(cos(x) > 0 ? 1 : -1);
+				else v = (float)(2 * fmod(x / (2 * pi), 1.0) - 1);
+				block[i] += v;
+			}
+			checksum += block[blockSize / 2];
+		}
+	}
+	double libmSamples = double(oscillators) * (blocks / 4) * blockSize;
+	double libmRate = libmSamples / secondsSince(start);
+
+	OscillatorBank bank(sampleRate);
+	for (int o = 0; o < oscillators; o++)
+		bank.add((Waveform)(o % 4), 110 + o * 7.3f, 1.0f / oscillators);
+	bank.fill(block.data(), blockSize); //first use builds the tables, keep that out of the timing
+
+	start = benchClock::now();
+	for (int b = 0; b < blocks; b++) {
+		bank.fill(block.data(), blockSize);
+		checksum += block[blockSize / 2];
+	}
+	double bankSamples = double(oscillators) * blocks * blockSize;
+	double bankRate = bankSamples / secondsSince(start);
+
+	printf("wavetable benchmark (%i oscillators, sine/triangle/square/saw)\n", oscillators);
+	printf("\tlibm per sample:   %8.1f Msamples/s, %6.0f oscillators in real time at %u Hz\n", libmRate / 1e6, libmRate / sampleRate, sampleRate);
+	printf("\tOscillatorBank:    %8.1f Msamples/s, %6.0f oscillators in real time at %u Hz (%.1fx)\n", bankRate / 1e6, bankRate / sampleRate, sampleRate, bankRate / libmRate);
+	printf("\t(checksum %f)\n", checksum);
+}
+
+void benchmarkSweep() {
+	const int blockSize = 1024;
+	const int blocks = 2000;
+	const unsigned int sampleRate = 44100;
+	const double pi = 3.14159265358979323846;
+	std::vector<short> block(blockSize);
+	long long checksum = 0;
+
+	//MM_render_one_buffer() in SineWaveC.cpp: one sin() per sample and a loop-carried frequency
+	benchClock::time_point start = benchClock::now();
+	float freq = 100.f;
+	float incr_freq = 0.1f;
+	for (int b = 0; b < blocks; b++) {
+		for (int i = 0; i < blockSize; ++i) {
+			block[i] = 32760 * sin((2.f * pi * freq) / sampleRate * (b * blockSize + i));
+			freq += incr_freq;
+			if (100.0 > freq || freq > 5000.0)
+				incr_freq *= -1.0f;
+		}
+		checksum += block[blockSize / 2];
+	}
+	double libmSeconds = secondsSince(start);
+
+	SweepOscillator sweep(100, 5000, 0.1f * sampleRate, sampleRate);
+	start = benchClock::now();
+	for (int b = 0; b < blocks; b++) {
+		sweep.fill(block.data(), blockSize);
+		checksum += block[blockSize / 2];
+	}
+	double sweepSeconds = secondsSince(start);
+
+	double samples = double(blockSize) * blocks;
+	printf("sweep benchmark (%i blocks of %i samples)\n", blocks, blockSize);
+	printf("\tsin() per sample: %8.1f Msamples/s\n", samples / libmSeconds / 1e6);
+	printf("\tSweepOscillator:  %8.1f Msamples/s (%.1fx)\n", samples / sweepSeconds / 1e6, libmSeconds / sweepSeconds);
+	printf("\t(checksum %lld)\n", checksum);
+}
+
+void benchmarkNoise() {
+	const int blockSize = 1024;
+	const int blocks = 4000;
+	std::vector<float> block(blockSize);
+	double checksum = 0;
+
+	//the way get_random() draws numbers elsewhere in the engine
+	std::mt19937 engine(1);
+	std::uniform_real_distribution<float> dist(-1, 1);
+	benchClock::time_point start = benchClock::now();
+	for (int b = 0; b < blocks; b++) {
+		for (int i = 0; i < blockSize; i++)
+			block[i] = dist(engine);
+		checksum += block[blockSize / 2];
+	}
+	double mtSeconds = secondsSince(start);
+
+	double samples = double(blockSize) * blocks;
+	printf("noise benchmark (%i blocks of %i samples)\n", blocks, blockSize);
+	printf("\tmt19937:        %8.1f Msamples/s\n", samples / mtSeconds / 1e6);
+
+	const char* names[] = { "white", "pink", "brown" };
+	for (int c = 0; c < 3; c++) {
+		NoiseGenerator noise((NoiseColor)c);
+		start = benchClock::now();
+		for (int b = 0; b < blocks; b++) {
+			noise.fill(block.data(), blockSize);
+			checksum += block[blockSize / 2];
+		}
+		double noiseSeconds = secondsSince(start);
+		printf("\t%-5s noise:    %8.1f Msamples/s (%.1fx)\n", names[c], samples / noiseSeconds / 1e6, mtSeconds / noiseSeconds);
+	}
+	printf("\t(checksum %f)\n", checksum);
+}
+
+// count random triangles with vertices within size of centers spread over [-halfExtent, halfExtent]^3
+static void addTriangleSoup(Scene& scene, int count, float halfExtent, float size, std::mt19937& engine) {
+	std::uniform_real_distribution<float> dist(-1, 1);
+	for (int i = 0; i < count; i++) {
+		glm::vec3 center = glm::vec3(dist(engine), dist(engine), dist(engine)) * halfExtent;
+		scene.addTriangle(Triangle(center + glm::vec3(dist(engine), dist(engine), dist(engine)) * size,
+									center + glm::vec3(dist(engine), dist(engine), dist(engine)) * size,
+									center + glm::vec3(dist(engine), dist(engine), dist(engine)) * size));
+	}
+}
+
+void benchmarkBVH() {
+	const int rays = 20000;
+	const float roomSize = 20;
+	std::mt19937 engine(7);
+	std::uniform_real_distribution<float> dist(-1, 1);
+
+	std::vector<Ray> batch;
+	for (int i = 0; i < rays; i++)
+		batch.push_back(Ray(glm::vec3(dist(engine), dist(engine), dist(engine)) * (roomSize * 0.5f), glm::vec3(dist(engine), dist(engine), dist(engine))));
+
+	printf("BVH benchmark (%i random rays through a triangle soup filling a %.0f unit cube)\n", rays, roomSize);
+	printf("\t%10s %10s %10s %14s %14s\n", "triangles", "build ms", "nodes", "BVH ns/ray", "brute ns/ray");
+	for (int triangles = 10; triangles <= 1000000; triangles *= 10) {
+		//triangles shrink as they multiply, so the room stays about as full
+		float size = roomSize / cbrtf((float)triangles);
+		Scene scene;
+		addTriangleSoup(scene, triangles, roomSize * 0.5f, size, engine);
+
+		benchClock::time_point start = benchClock::now();
+		scene.buildBVH();
+		double buildSeconds = secondsSince(start);
+
+		int hits = 0;
+		HitInfo hit;
+		start = benchClock::now();
+		const BVH* bvh = scene.getBVH();
+		for (int i = 0; i < rays; i++)
+			hits += bvh->intersect(scene, hit, batch[i]);
+		double bvhSeconds = secondsSince(start);
+
+		//the brute force loop is only timed where it finishes in reasonable time
+		double bruteNs = 0;
+		if (triangles <= 10000) {
+			int bruteRays = triangles <= 1000 ? rays : rays / 10;
+			start = benchClock::now();
+			for (int i = 0; i < bruteRays; i++)
+				hits += IntersectRayTriangle(scene, hit, batch[i]);
+			bruteNs = secondsSince(start) / bruteRays * 1e9;
+		}
+
+		printf("\t%10i %10.1f %10i %14.1f ", triangles, buildSeconds * 1e3, scene.getBVH()->nodeCount(), bvhSeconds / rays * 1e9);
+		if (bruteNs > 0) printf("%14.1f\n", bruteNs);
+		else printf("%14s\n", "-");
+		if (triangles == 1000000)
+			printf("\t(hits %i)\n", hits);
+	}
+}
+
+void benchmarkRayKernels() {
+	const int primitives = 1024;
+	const int rays = 20000;
+	std::mt19937 engine(11);
+	std::uniform_real_distribution<float> dist(-1, 1);
+
+	TriangleStore store;
+	for (int i = 0; i < primitives; i++)
+		store.add(Triangle(glm::vec3(dist(engine), dist(engine), dist(engine)) * 10.0f,
+							glm::vec3(dist(engine), dist(engine), dist(engine)) * 10.0f,
+							glm::vec3(dist(engine), dist(engine), dist(engine)) * 10.0f));
+	const TriangleSoA& tris = store.arrays();
+
+	std::vector<float> data[4];
+	for (int k = 0; k < 4; k++)
+		for (int i = 0; i < primitives + RAY_KERNEL_PAD; i++)
+			data[k].push_back(dist(engine) * 10);
+	for (int i = 0; i < primitives; i++)
+		data[3][i] = fabsf(data[3][i]) * 0.05f;
+	SphereSoA spheres;
+	for (int k = 0; k < 3; k++)
+		spheres.center[k] = data[k].data();
+	spheres.radius = data[3].data();
+
+	std::vector<KernelRay> batch(rays);
+	for (int i = 0; i < rays; i++) {
+		batch[i] = { dist(engine), dist(engine), dist(engine), dist(engine), dist(engine), dist(engine), 0 };
+		batch[i].dd = batch[i].dx * batch[i].dx + batch[i].dy * batch[i].dy + batch[i].dz * batch[i].dz;
+	}
+
+	printf("ray kernel benchmark (one ray against %i primitives, %s selected on this CPU)\n", primitives, rayKernelName(rayKernels().level));
+	double scalarTriangles = 0, scalarSpheres = 0;
+	for (int level = KERNEL_SCALAR; level <= KERNEL_AVX2; level++) {
+		RayKernels kernels = rayKernels((RayKernelLevel)level);
+		if (kernels.level != level)
+			continue; // not supported here
+
+		long long hits = 0;
+		benchClock::time_point start = benchClock::now();
+		for (int i = 0; i < rays; i++) {
+			float t = 1e30f;
+			hits += kernels.triangles(batch[i], tris, 0, primitives, t) >= 0;
+		}
+		double triangleRate = double(rays) * primitives / secondsSince(start);
+
+		start = benchClock::now();
+		for (int i = 0; i < rays; i++) {
+			float t = 1e30f;
+			hits += kernels.spheres(batch[i], spheres, 0, primitives, t) >= 0;
+		}
+		double sphereRate = double(rays) * primitives / secondsSince(start);
+
+		if (level == KERNEL_SCALAR) {
+			scalarTriangles = triangleRate;
+			scalarSpheres = sphereRate;
+		}
+		printf("\t%-7s triangles: %7.1f Mtests/s (%.1fx)   spheres: %7.1f Mtests/s (%.1fx)   (hits %lld)\n", rayKernelName(kernels.level),
+			triangleRate / 1e6, triangleRate / scalarTriangles, sphereRate / 1e6, sphereRate / scalarSpheres, hits);
+	}
+}
+
+void benchmarkRayBatch() {
+	const int rays = 20000;
+	const int triangles = 10000;
+	std::mt19937 engine(13);
+	std::uniform_real_distribution<float> dist(-1, 1);
+
+	//triangle soup around the listener with a few sources in it
+	Scene scene;
+	int sourceMaterial = scene.addMaterial(Material(0.4, true));
+	addTriangleSoup(scene, triangles, 10, 1, engine);
+	for (int i = 0; i < 8; i++)
+		scene.addSphere(Sphere(glm::vec3(dist(engine), dist(engine), dist(engine)) * 8.0f, 1, sourceMaterial));
+	scene.buildBVH();
+	Listener listener;
+	const uint64_t frame = 1;
+
+	//the same rays TraceRayBatch traces for this frame, one after the other
+	std::vector<glm::vec3> dirs;
+	std::vector<reflectInfo> serial;
+	benchClock::time_point start = benchClock::now();
+	GenerateDirections(SAMPLING_FIBONACCI, rays, frame, dirs);
+	for (int i = 0; i < rays; i++) {
+		std::vector<reflectInfo> path = RayTracer(scene, Ray(listener.pos, dirs[i]));
+		serial.insert(serial.end(), path.begin(), path.end());
+	}
+	double serialSeconds = secondsSince(start);
+
+	std::vector<reflectInfo> reflections;
+	start = benchClock::now();
+	TraceRayBatch(scene, listener, rays, reflections, frame);
+	double batchSeconds = secondsSince(start);
+
+	//keyed random numbers and ordered merging make the batch independent of the thread count
+	bool identical = serial.size() == reflections.size();
+	for (size_t i = 0; identical && i < serial.size(); i++)
+		identical = serial[i].hit.position == reflections[i].hit.position && serial[i].totalAbsorbed == reflections[i].totalAbsorbed;
+
+	printf("ray batch benchmark (%i rays, %i triangles, %i worker threads)\n", rays, triangles, sharedPool().size());
+	printf("\tserial:        %8.0f rays/s (%zu reflections)\n", rays / serialSeconds, serial.size());
+	printf("\tTraceRayBatch: %8.0f rays/s (%zu reflections, %.1fx, %s serial)\n", rays / batchSeconds, reflections.size(),
+		serialSeconds / batchSeconds, identical ? "identical to" : "DIFFERS from");
+}
+
+// two triangles per face of an axis aligned box
+static void addBox(Scene& scene, glm::vec3 lo, glm::vec3 hi, int material = 0) {
+	glm::vec3 c[8];
+	for (int i = 0; i < 8; i++)
+		c[i] = glm::vec3(i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y, i & 4 ? hi.z : lo.z);
+	const int faces[6][4] = { {0, 2, 6, 4}, {1, 5, 7, 3}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 6, 7, 5} };
+	for (int f = 0; f < 6; f++) {
+		scene.addTriangle(Triangle(c[faces[f][0]], c[faces[f][1]], c[faces[f][2]], material));
+		scene.addTriangle(Triangle(c[faces[f][0]], c[faces[f][2]], c[faces[f][3]], material));
+	}
+}
+
+// 10 x 4 x 6 room of the given walls with a small source off to one side, the listener across from it
+static void makeShoebox(Scene& scene, Listener& listener, const Material& walls) {
+	int sourceMaterial = scene.addMaterial(Material(0.4, true));
+	addBox(scene, glm::vec3(-5, -2, -3), glm::vec3(5, 2, 3), scene.addMaterial(walls));
+	scene.addSphere(Sphere(glm::vec3(3, 0.5f, 1), 1, sourceMaterial));
+	scene.buildBVH();
+	listener.pos = glm::vec3(-2, -0.5f, -1);
+}
+
+// source energy reaching the listener per ray: the product of every absorption along each source-reaching path
+static double sourceEnergy(const Scene& scene, const Listener& listener, const std::vector<glm::vec3>& dirs) {
+	double energy = 0;
+	for (int i = 0; i < dirs.size(); i++) {
+		std::vector<reflectInfo> path = RayTracer(scene, Ray(listener.pos, dirs[i]));
+		if (!path.empty())
+			energy += path[0].totalAbsorbed;
+	}
+	return energy / dirs.size();
+}
+
+void benchmarkRaySampling() {
+	const int trials = 32;
+	const int minRays = 64, maxRays = 16384;
+	const double targetError = 0.05;
+	const int referenceRays = 1 << 20;
+
+	//shoebox room with a small source off to one side
+	Scene scene;
+	Listener listener;
+	makeShoebox(scene, listener, Material(0.8));
+
+	//reference from a large Sobol set, split over the pool
+	const int referenceChunks = 64;
+	std::vector<double> partial(referenceChunks);
+	sharedPool().parallelFor(referenceChunks, [&](int c) {
+		std::vector<glm::vec3> dirs;
+		GenerateDirections(SAMPLING_SOBOL, referenceRays / referenceChunks, 1000 + c, dirs);
+		partial[c] = sourceEnergy(scene, listener, dirs);
+	});
+	double reference = 0;
+	for (int c = 0; c < referenceChunks; c++)
+		reference += partial[c] / referenceChunks;
+
+	printf("ray sampling convergence (relative rms error of source energy over %i rotations, reference %.5f)\n", trials, reference);
+	printf("\t%-10s", "rays");
+	for (int n = minRays; n <= maxRays; n *= 2)
+		printf(" %7i", n);
+	printf("   rays for %.0f%%\n", targetError * 100);
+
+	const RaySampling schemes[] = { SAMPLING_CUBE, SAMPLING_RANDOM, SAMPLING_STRATIFIED, SAMPLING_FIBONACCI, SAMPLING_SOBOL };
+	for (RaySampling scheme : schemes) {
+		printf("\t%-10s", raySamplingName(scheme));
+		int needed = 0;
+		for (int n = minRays; n <= maxRays; n *= 2) {
+			std::vector<double> errors(trials);
+			sharedPool().parallelFor(trials, [&](int t) {
+				std::vector<glm::vec3> dirs;
+				GenerateDirections(scheme, n, (uint64_t)t * 7919 + n, dirs);
+				double e = sourceEnergy(scene, listener, dirs) / reference - 1;
+				errors[t] = e * e;
+			});
+			double rms = 0;
+			for (int t = 0; t < trials; t++)
+				rms += errors[t] / trials;
+			rms = sqrt(rms);
+			if (needed == 0 && rms <= targetError)
+				needed = n;
+			printf(" %6.2f%%", rms * 100);
+		}
+		if (needed > 0)
+			printf("   %i\n", needed);
+		else
+			printf("   > %i\n", maxRays);
+	}
+}
+
+// paths in a reflection list, each one ends on a source
+static int countPaths(const std::vector<reflectInfo>& reflections) {
+	int paths = 0;
+	for (int i = 0; i < reflections.size(); i++)
+		paths += reflections[i].hit.mtl.isSource ? 1 : 0;
+	return paths;
+}
+
+// paths that hit different primitives, many rays find the same one
+static int countDistinctPaths(const std::vector<reflectInfo>& reflections) {
+	std::set<std::vector<unsigned int>> distinct;
+	std::vector<unsigned int> sequence;
+	for (int i = 0; i < reflections.size(); i++) {
+		sequence.push_back(reflections[i].hit.primitive);
+		if (reflections[i].hit.mtl.isSource) {
+			distinct.insert(sequence);
+			sequence.clear();
+		}
+	}
+	return (int)distinct.size();
+}
+
+void benchmarkImageSources() {
+	const int frames = 100;
+
+	//same room as the sampling benchmark
+	Scene scene;
+	Listener listener;
+	makeShoebox(scene, listener, Material(0.8));
+
+	printf("image source benchmark (shoebox, 12 triangles, %i frames)\n", frames);
+	std::vector<reflectInfo> reflections;
+	for (int order = 1; order <= 4; order++) {
+		ImageSourceEngine engine(order);
+		benchClock::time_point start = benchClock::now();
+		engine.update(scene);
+		double buildSeconds = secondsSince(start);
+
+		//the listener walks a little each frame, the tree stays cached
+		start = benchClock::now();
+		for (int f = 0; f < frames; f++) {
+			Listener moved = listener;
+			moved.pos.x += 0.01f * f;
+			reflections.clear();
+			engine.trace(scene, moved, reflections);
+		}
+		double frameSeconds = secondsSince(start) / frames;
+		printf("\torder %i: %6i images, build %7.3f ms, %7.3f ms per frame, %3i paths\n", order, engine.imageCount(),
+			buildSeconds * 1000, frameSeconds * 1000, engine.validCount());
+	}
+
+	for (int rays = 200; rays <= 20000; rays *= 10) {
+		benchClock::time_point start = benchClock::now();
+		for (int f = 0; f < frames; f++)
+			TraceRayBatch(scene, listener, rays, reflections, f);
+		double frameSeconds = secondsSince(start) / frames;
+		printf("\t%5i rays:                                 %7.3f ms per frame, %3i paths (many repeat the same reflection sequence)\n",
+			rays, frameSeconds * 1000, countPaths(reflections));
+	}
+}
+
+void benchmarkPathReuse() {
+	const int frames = 200;
+	const int rays = 2000;
+
+	//the shoebox again, with a curved reflector that can only be retraced
+	Scene scene;
+	Listener listener;
+	makeShoebox(scene, listener, Material(0.8));
+	scene.addSphere(Sphere(glm::vec3(0, 1, 2), 0.7f));
+	scene.buildBVH();
+
+	//listener walking at 1.5 m/s, a batch every 20 ms
+	std::vector<reflectInfo> reflections;
+	long long freshPaths = 0;
+	benchClock::time_point start = benchClock::now();
+	for (int f = 0; f < frames; f++) {
+		listener.pos = glm::vec3(-3 + 0.03f * f, -0.5f, -1);
+		TraceRayBatch(scene, listener, rays, reflections, f);
+		freshPaths += countDistinctPaths(reflections);
+	}
+	double freshSeconds = secondsSince(start) / frames;
+
+	PathCache cache;
+	long long cachedPaths = 0, reused = 0;
+	start = benchClock::now();
+	for (int f = 0; f < frames; f++) {
+		listener.pos = glm::vec3(-3 + 0.03f * f, -0.5f, -1);
+		cache.trace(scene, listener, rays, reflections, f);
+		cachedPaths += countDistinctPaths(reflections);
+		reused += cache.reusedCount();
+	}
+	double cachedSeconds = secondsSince(start) / frames;
+
+	printf("temporal path reuse (%i rays per pass, listener moving 3 cm per pass, %i passes)\n", rays, frames);
+	printf("\tTraceRayBatch: %7.3f ms per pass, %6.1f distinct paths per pass\n", freshSeconds * 1000, (double)freshPaths / frames);
+	printf("\tPathCache:     %7.3f ms per pass, %6.1f distinct paths per pass (%.1f reused), %.1fx faster\n", cachedSeconds * 1000,
+		(double)cachedPaths / frames, (double)reused / frames, freshSeconds / cachedSeconds);
+}
+
+void benchmarkEchogram() {
+	const int passes = 100;
+	const unsigned int sampleRate = 22050;
+	const int segmentSamples = sampleRate / 5;	// the 0.2 s segment main renders
+
+	//shoebox with walls that absorb the highs more than the lows
+	const float wallBands[MATERIAL_BANDS] = { 0.9f, 0.7f, 0.5f, 0.3f };
+	Scene scene;
+	Listener listener;
+	makeShoebox(scene, listener, Material(wallBands));
+
+	ImageSourceEngine images(3);
+	PathCache cache;
+	std::vector<reflectInfo> reflections;
+	cache.trace(scene, listener, 2000, reflections, 0);
+	images.trace(scene, listener, reflections);
+
+	SineOscillator osc(440, sampleRate);
+	std::vector<float> dry(segmentSamples), wet;
+	osc.fill(dry.data(), segmentSamples);
+
+	Echogram echogram;
+	benchClock::time_point start = benchClock::now();
+	for (int p = 0; p < passes; p++) {
+		echogram.clear();
+		echogram.addPaths(reflections);
+	}
+	double accumulateSeconds = secondsSince(start) / passes;
+	start = benchClock::now();
+	for (int p = 0; p < passes; p++)
+		echogram.render(dry.data(), segmentSamples, sampleRate, wet, p);
+	double renderSeconds = secondsSince(start) / passes;
+
+	printf("echogram benchmark (%zu reflections from the path cache and image sources)\n", reflections.size());
+	printf("\t%i distinct paths into %i bins of %.0f ms, tail %.0f ms, 1 voice instead of %i\n", echogram.pathCount(), echogram.bins(),
+		echogram.getBinSeconds() * 1000, echogram.tailSeconds() * 1000, countPaths(reflections));
+	printf("\tenergy per band: %.4f %.4f %.4f %.4f\n", echogram.bandEnergy(0), echogram.bandEnergy(1), echogram.bandEnergy(2), echogram.bandEnergy(3));
+	printf("\taccumulate %.3f ms, render 0.2 s segment %.3f ms\n", accumulateSeconds * 1000, renderSeconds * 1000);
+}
+
+void runBenchmarks() {
+	benchmarkOscillators();
+	benchmarkWavetables();
+	benchmarkSweep();
+	benchmarkNoise();
+	benchmarkRayKernels();
+	benchmarkBVH();
+	benchmarkRayBatch();
+	benchmarkRaySampling();
+	benchmarkImageSources();
+	benchmarkPathReuse();
+	benchmarkEchogram();
+}
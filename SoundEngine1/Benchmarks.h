@@ -0,0 +1,40 @@
+#pragma once
+#ifndef BENCHMARKS
+#define BENCHMARKS
+
+// throughput of the block oscillator against the per-sample cos() loop sineW used
+void benchmarkOscillators();
+
+// oscillator-samples per second of the wavetable bank against per-sample libm waveforms
+void benchmarkWavetables();
+
+// the SineWaveC frequency sweep (sin() per sample) against SweepOscillator
+void benchmarkSweep();
+
+// white/pink/brown NoiseGenerator against std::mt19937 with a uniform distribution
+void benchmarkNoise();
+
+// intersection tests per second of the scalar, SSE4.1 and AVX2 ray kernels
+void benchmarkRayKernels();
+
+// BVH build time and trace cost per ray from 10 to 1M triangles, next to the brute force loop
+void benchmarkBVH();
+
+// rays per second of the serial RayTracer loop against TraceRayBatch on the thread pool, and that both trace the same paths
+void benchmarkRayBatch();
+
+// rays each direction scheme of RaySampling.h needs to estimate the source energy in a room to the same error
+void benchmarkRaySampling();
+
+// image tree build and per frame validation cost by reflection order, next to the paths random rays find
+void benchmarkImageSources();
+
+// cost of a tracing pass with PathCache against tracing every pass from scratch, for a slowly walking listener
+void benchmarkPathReuse();
+
+// cost of turning the traced paths into an echogram and rendering a segment through it
+void benchmarkEchogram();
+
+// runs every benchmark above. Started with: SoundEngine1 --bench
+void runBenchmarks();
+#endif
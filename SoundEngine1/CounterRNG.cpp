@@ -0,0 +1,45 @@
+#include "CounterRNG.h"
+
+static inline void mulhilo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo) {
+	uint64_t product = (uint64_t)a * b;
+	hi = (uint32_t)(product >> 32);
+	lo = (uint32_t)product;
+}
+
+void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) {
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for (int round = 0; round < 10; round++) {
+		uint32_t hi0, lo0, hi1, lo1;
+		mulhilo(0xD2511F53u, c0, hi0, lo0);
+		mulhilo(0xCD9E8D57u, c2, hi1, lo1);
+		c0 = hi1 ^ c1 ^ k0;
+		c1 = lo1;
+		c2 = hi0 ^ c3 ^ k1;
+		c3 = lo0;
+		k0 += 0x9E3779B9u;	// Weyl sequence key schedule
+		k1 += 0xBB67AE85u;
+	}
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+RayRandom::RayRandom(uint64_t frame, uint32_t ray, uint32_t bounce) {
+	key[0] = (uint32_t)frame;
+	key[1] = (uint32_t)(frame >> 32);
+	counter[0] = ray;
+	counter[1] = bounce;
+	counter[2] = 0;
+	counter[3] = 0;
+}
+
+uint32_t RayRandom::next() {
+	if (used == 4) {
+		philox4x32(counter, key, block);
+		counter[2]++;
+		used = 0;
+	}
+	return block[used++];
+}
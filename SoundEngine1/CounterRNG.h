@@ -0,0 +1,35 @@
+#pragma once
+#ifndef COUNTERRNG
+#define COUNTERRNG
+#include <stdint.h>
+
+// the ray index used for draws that belong to a whole batch rather than one ray (rotation, scramble)
+#define RNG_BATCH_RAY 0xFFFFFFFFu
+
+/**
+ * Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+ * a keyed bijection on 128 bit counters: the same key and counter always give the same four words
+ */
+void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
+
+/**
+ * random numbers for one (frame, ray, bounce), with no state shared with any other ray
+ * the n-th draw is a pure function of the four, so a traced batch is bit identical on any
+ * number of threads and in any order
+ */
+class RayRandom {
+private:
+	uint32_t key[2];
+	uint32_t counter[4];	// ray, bounce, block of four draws, 0
+	uint32_t block[4];
+	int used = 4;			// draws taken from block
+public:
+	RayRandom(uint64_t frame, uint32_t ray, uint32_t bounce = 0);
+
+	uint32_t next();
+	// uniform in [0, 1), 24 bits so it never rounds up to 1
+	float uniform01() { return (next() >> 8) * (1.0f / 16777216.0f); }
+	// uniform in [-1, 1)
+	float uniform() { return uniform01() * 2 - 1; }
+};
+#endif
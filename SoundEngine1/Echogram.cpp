@@ -0,0 +1,132 @@
+#include "Echogram.h"
+#include "CounterRNG.h"
+
+#include <math.h>
+#include <set>
+#include <algorithm>
+
+Echogram::Echogram(float _binSeconds, float lengthSeconds) : binSeconds(_binSeconds) {
+	binCount = std::max(1, (int)ceilf(lengthSeconds / binSeconds));
+	energy.assign(binCount * ECHOGRAM_BANDS, 0.0f);
+}
+
+void Echogram::clear() {
+	std::fill(energy.begin(), energy.end(), 0.0f);
+	paths = 0;
+	lastBin = -1;
+}
+
+void Echogram::addPath(float pathLength, const float bandEnergy[ECHOGRAM_BANDS]) {
+	int bin = (int)(pathLength / SPEED_OF_SOUND / binSeconds);
+	if (bin < 0 || bin >= binCount)
+		return;
+	for (int b = 0; b < ECHOGRAM_BANDS; b++)
+		energy[bin * ECHOGRAM_BANDS + b] += bandEnergy[b];
+	lastBin = std::max(lastBin, bin);
+	paths++;
+}
+
+int Echogram::addPaths(const std::vector<reflectInfo>& reflections) {
+	std::set<std::vector<unsigned int>> seen;
+	std::vector<unsigned int> sequence;
+	int added = 0;
+	int begin = 0;
+	for (int i = 0; i < reflections.size(); i++) {
+		sequence.push_back(reflections[i].hit.primitive);
+		if (!reflections[i].hit.mtl.isSource)
+			continue;
+
+		if (seen.insert(sequence).second) {
+			//the source's own material does not reflect anything, only the hits before it do
+			float distance = std::max(reflections[i].pathLength, ECHOGRAM_REFERENCE_DISTANCE);
+			float bandEnergy[ECHOGRAM_BANDS];
+			for (int b = 0; b < ECHOGRAM_BANDS; b++) {
+				bandEnergy[b] = 1 / (distance * distance);
+				for (int h = begin; h < i; h++)
+					bandEnergy[b] *= reflections[h].hit.mtl.soundDampenPercent(b);
+			}
+			addPath(reflections[i].pathLength, bandEnergy);
+			added++;
+		}
+		sequence.clear();
+		begin = i + 1;
+	}
+	return added;
+}
+
+float Echogram::bandEnergy(int band) const {
+	float total = 0;
+	for (int bin = 0; bin <= lastBin; bin++)
+		total += energy[bin * ECHOGRAM_BANDS + band];
+	return total;
+}
+
+// in place one pole low pass
+static void lowPass(std::vector<float>& signal, float cutoff, unsigned int sampleRate) {
+	float a = 1 - expf(-2 * 3.14159265f * cutoff / sampleRate);
+	float y = 0;
+	for (int i = 0; i < signal.size(); i++) {
+		y += a * (signal[i] - y);
+		signal[i] = y;
+	}
+}
+
+void Echogram::render(const float* dry, int count, unsigned int sampleRate, std::vector<float>& out, uint64_t seed) const {
+	int tail = (int)ceilf(tailSeconds() * sampleRate);
+	int length = count + tail;
+	out.assign(length, 0.0f);
+	if (lastBin < 0)
+		return;
+
+	const float crossovers[ECHOGRAM_BANDS - 1] = { ECHOGRAM_CROSSOVER_0, ECHOGRAM_CROSSOVER_1, ECHOGRAM_CROSSOVER_2 };
+	std::vector<float> band(length), lower(length);
+	for (int b = 0; b < ECHOGRAM_BANDS; b++) {
+		//the taps are sparse, so convolve tap by tap before filtering: both are linear
+		std::fill(band.begin(), band.end(), 0.0f);
+		for (int bin = 0; bin <= lastBin; bin++) {
+			float e = get(bin, b);
+			if (e <= 0)
+				continue;
+			//same sign in every band, so equal band energies add back up to a plain delayed copy
+			RayRandom rng(seed, bin);
+			float amplitude = sqrtf(e) * ((rng.next() & 1) ? 1.0f : -1.0f);
+			int delay = std::min((int)(bin * binSeconds * sampleRate), tail);
+			for (int i = 0; i < count; i++)
+				band[delay + i] += amplitude * dry[i];
+		}
+
+		//keep what lies between this band's crossovers: lowpass(upper) - lowpass(lower)
+		if (b > 0) {
+			lower = band;
+			lowPass(lower, crossovers[b - 1], sampleRate);
+		}
+		if (b < ECHOGRAM_BANDS - 1)
+			lowPass(band, crossovers[b], sampleRate);
+		for (int i = 0; i < length; i++)
+			out[i] += b > 0 ? band[i] - lower[i] : band[i];
+	}
+}
+
+void EchogramStream::render(const Echogram& echogram, const float* dry, int count, unsigned int sampleRate, short* out, uint64_t seed) {
+	echogram.render(dry, count, sampleRate, wet, seed);
+
+	//overlap-add the tails of the earlier blocks, then keep whatever reaches past this block
+	if (wet.size() < tail.size())
+		wet.resize(tail.size(), 0.0f);
+	for (int i = 0; i < tail.size(); i++)
+		wet[i] += tail[i];
+	tail.assign(wet.begin() + std::min((int)wet.size(), count), wet.end());
+
+	float peak = 0;
+	for (int i = 0; i < count; i++)
+		peak = std::max(peak, fabsf(wet[i]));
+	float target = peak > 1 ? 1 / peak : 1;
+
+	//a ramp up to target never exceeds full scale, a ramp down could before it gets there
+	float from = target < gain ? target : gain;
+	for (int i = 0; i < count; i++) {
+		float g = from + (target - from) * i / count;
+		out[i] = (short)(32767 * g * wet[i]);
+	}
+	gain = target;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef ECHOGRAM
+#define ECHOGRAM
+#include <vector>
+#include <stdint.h>
+
+#include "RayTracer.h"
+
+// one band per material band, split at these frequencies in Hz
+#define ECHOGRAM_BANDS MATERIAL_BANDS
+#define ECHOGRAM_CROSSOVER_0 250.0f
+#define ECHOGRAM_CROSSOVER_1 1000.0f
+#define ECHOGRAM_CROSSOVER_2 4000.0f
+#define SPEED_OF_SOUND 343.0f
+// paths shorter than this are not louder than at this distance, like OpenAL's reference distance
+#define ECHOGRAM_REFERENCE_DISTANCE 1.0f
+
+/**
+ * energy reaching the listener over time, per frequency band: a compact description of the
+ * room's impulse response, built from the source-reaching paths of the tracers
+ * a path of length L that reflects on materials m1..mk adds m1 * .. * mk / L^2 in every band,
+ * to the bin of its arrival time L / SPEED_OF_SOUND
+ */
+class Echogram {
+private:
+	float binSeconds;
+	int binCount;
+	std::vector<float> energy;	// energy[bin * ECHOGRAM_BANDS + band]
+	int paths = 0;
+	int lastBin = -1;			// latest bin holding any energy
+public:
+	Echogram(float _binSeconds = 0.001f, float lengthSeconds = 0.5f);
+
+	void clear();
+	// one path; arrivals after the end of the echogram are dropped
+	void addPath(float pathLength, const float bandEnergy[ECHOGRAM_BANDS]);
+	/**
+	 * every path of a reflection list as RayTracer(), TraceRayBatch(), PathCache or ImageSourceEngine
+	 * return them (each path ends on a source hit). A path that hits the same primitives as one added
+	 * before is only counted once, so lists of several tracers can be merged. Returns the paths added
+	 */
+	int addPaths(const std::vector<reflectInfo>& reflections);
+
+	float get(int bin, int band) const { return energy[bin * ECHOGRAM_BANDS + band]; }
+	float bandEnergy(int band) const;
+	int bins() const { return binCount; }
+	float getBinSeconds() const { return binSeconds; }
+	int pathCount() const { return paths; }
+	// seconds until the last arrival, 0 if empty
+	float tailSeconds() const { return (lastBin + 1) * binSeconds; }
+
+	/**
+	 * dry convolved with the impulse response the echogram describes: every bin becomes a tap of
+	 * amplitude sqrt(energy) per band with a random sign per bin, each band is then band limited by one pole crossovers
+	 * out holds count + tailSeconds() * sampleRate samples; the signs are keyed by seed
+	 */
+	void render(const float* dry, int count, unsigned int sampleRate, std::vector<float>& out, uint64_t seed = 0) const;
+};
+
+/**
+ * consecutive blocks of a signal played through a changing echogram
+ * each block's reverb tail is kept and added into the following blocks (overlap-add), so blocks
+ * played back to back join up without gaps; the output is scaled rather than clipped: the gain drops
+ * at once when a block would exceed full scale, and recovers over a block when it no longer does
+ */
+class EchogramStream {
+private:
+	std::vector<float> wet;
+	std::vector<float> tail;	// rendered samples past the end of the blocks so far
+	float gain = 1;
+public:
+	void clear() { tail.clear(); gain = 1; }
+	// count samples of dry through echogram, plus the tails of earlier blocks, as 16 bit PCM
+	void render(const Echogram& echogram, const float* dry, int count, unsigned int sampleRate, short* out, uint64_t seed = 0);
+};
+#endif
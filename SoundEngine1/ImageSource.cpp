@@ -0,0 +1,198 @@
+#include "ImageSource.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <set>
+
+// signed distance of p from the plane of triangle index
+static float planeDistance(const TriangleStore& triangles, int index, const glm::vec3& p) {
+	return glm::dot(p - triangles.vertex0(index), triangles.getNormal(index));
+}
+
+// true if any corner of the triangle lies on the side of the plane given by sign
+static bool inFrontOfPlane(const TriangleStore& triangles, int plane, int index, float side) {
+	Triangle tri = triangles.get(index);
+	return planeDistance(triangles, plane, tri.v0) * side > IMAGE_PLANE_EPSILON
+		|| planeDistance(triangles, plane, tri.v1) * side > IMAGE_PLANE_EPSILON
+		|| planeDistance(triangles, plane, tri.v2) * side > IMAGE_PLANE_EPSILON;
+}
+
+void ImageSourceEngine::build(const Scene& scene) {
+	images.clear();
+	const std::vector<Sphere>& spheres = scene.getSpheres();
+	const TriangleStore& triangles = scene.getTriangles();
+
+	for (int i = 0; i < spheres.size(); i++) {
+		if (!scene.getMaterial(spheres[i].material).isSource)
+			continue;
+		ImageNode root = { spheres[i].center, -1, -1, i, 0 };
+		images.push_back(root);
+	}
+
+	//breadth first, so a capped tree still holds every image of the lower orders
+	int levelBegin = 0;
+	for (int order = 1; order <= maxOrder; order++) {
+		int levelEnd = (int)images.size();
+		for (int p = levelBegin; p < levelEnd; p++) {
+			for (int t = 0; t < triangles.size(); t++) {
+				if (t == images[p].triangle)
+					continue;	//mirroring back across the same plane gives the parent's parent
+
+				float distance = planeDistance(triangles, t, images[p].position);
+				if (fabsf(distance) <= IMAGE_PLANE_EPSILON)
+					continue;	//the image is its own mirror, no path reflects there
+				//the path leaves this reflector on the parent image's side, so the parent reflector must reach into it
+				if (images[p].triangle >= 0 && !inFrontOfPlane(triangles, t, images[p].triangle, distance > 0 ? 1.0f : -1.0f))
+					continue;
+
+				if (images.size() >= maxImages)
+					return;
+				ImageNode image = { images[p].position - 2 * distance * triangles.getNormal(t), t, p, images[p].source, order };
+				images.push_back(image);
+			}
+		}
+		levelBegin = levelEnd;
+	}
+}
+
+void ImageSourceEngine::update(const Scene& scene) {
+	if (built && sceneVersion == scene.getVersion())
+		return;
+	build(scene);
+	sceneVersion = scene.getVersion();
+	built = true;
+}
+
+// leg from `from` towards image, reflecting on triangle on the way; appends the reflection and moves from onto it
+static bool reflectLeg(const Scene& scene, glm::vec3& from, float& pathLength, const glm::vec3& image, int triangle, std::vector<reflectInfo>& path) {
+	glm::vec3 toImage = image - from;
+	float imageDistance = glm::length(toImage);
+	if (imageDistance <= 0)
+		return false;
+	Ray ray(from, toImage / imageDistance);
+
+	//the leg has to cross the reflector itself, not just its plane
+	float t;
+	if (!HitTriangle(scene.getTriangle(triangle), ray, t) || t >= imageDistance)
+		return false;
+
+	//and nothing may stand in front of it
+	HitInfo hit;
+	Ray offset(from + ray.getDir() * 0.0001f, ray.getDir());
+	float tolerance = 1e-4f * t + 1e-4f;
+	if (IntersectScene(scene, hit, offset) && hit.t + 0.0001f < t - tolerance)
+		return false;
+
+	SetTriangleHit(scene, triangle, ray, t, hit);
+	pathLength += t;
+	reflectInfo reflection(hit);
+	reflection.pathLength = pathLength;
+	path.push_back(reflection);
+
+	from = hit.position;
+	return true;
+}
+
+// last leg: the first thing seen towards the source has to be that source
+static bool sourceLeg(const Scene& scene, const glm::vec3& from, float pathLength, int source, std::vector<reflectInfo>& path) {
+	const Sphere& sphere = scene.getSpheres()[source];
+	glm::vec3 toSource = sphere.center - from;
+	float sourceDistance = glm::length(toSource);
+	if (sourceDistance <= 0)
+		return false;
+	Ray ray(from + toSource / sourceDistance * 0.0001f, toSource / sourceDistance);
+	HitInfo hit;
+	if (!IntersectScene(scene, hit, ray) || !hit.mtl.isSource || hit.primitive != (source | BVH_SPHERE_BIT))
+		return false;
+
+	reflectInfo arrival(hit);
+	arrival.pathLength = pathLength + 0.0001f + hit.t;
+	path.push_back(arrival);
+	ReverseAbsorptionOrder(path);
+	return true;
+}
+
+bool ImageSourceEngine::validate(const Scene& scene, const glm::vec3& listener, int image, std::vector<reflectInfo>& path) const {
+	path.clear();
+	glm::vec3 from = listener;
+	float pathLength = 0;
+
+	//walk from the listener towards the source, one reflector per image
+	int node = image;
+	for (; images[node].triangle >= 0; node = images[node].parent) {
+		if (!reflectLeg(scene, from, pathLength, images[node].position, images[node].triangle, path))
+			return false;
+	}
+	return sourceLeg(scene, from, pathLength, images[node].source, path);
+}
+
+bool SolveSpecularPath(const Scene& scene, const glm::vec3& listener, const std::vector<int>& triangles, int source, std::vector<reflectInfo>& path) {
+	path.clear();
+	const TriangleStore& store = scene.getTriangles();
+	int order = (int)triangles.size();
+
+	//mirror the source back across the reflectors, the last one the sound meets first
+	std::vector<glm::vec3> images(order);
+	glm::vec3 image = scene.getSpheres()[source].center;
+	for (int i = order - 1; i >= 0; i--) {
+		glm::vec3 normal = store.getNormal(triangles[i]);
+		image -= 2 * glm::dot(image - store.vertex0(triangles[i]), normal) * normal;
+		images[i] = image;
+	}
+
+	glm::vec3 from = listener;
+	float pathLength = 0;
+	for (int i = 0; i < order; i++) {
+		if (!reflectLeg(scene, from, pathLength, images[i], triangles[i], path))
+			return false;
+	}
+	return sourceLeg(scene, from, pathLength, source, path);
+}
+
+// what every path of a reflection list hit, each path ends on a source hit
+static void collectPathKeys(const std::vector<reflectInfo>& reflections, std::set<std::vector<unsigned int>>& keys) {
+	std::vector<unsigned int> sequence;
+	for (int i = 0; i < reflections.size(); i++) {
+		sequence.push_back(reflections[i].hit.primitive);
+		if (reflections[i].hit.mtl.isSource) {
+			keys.insert(sequence);
+			sequence.clear();
+		}
+	}
+}
+
+int ImageSourceEngine::trace(const Scene& scene, const Listener& listener, std::vector<reflectInfo>& reflections) {
+	update(scene);
+	int count = (int)images.size();
+
+	//paths a ray tracer already put in the list are not added a second time
+	std::set<std::vector<unsigned int>> existing;
+	collectPathKeys(reflections, existing);
+
+	//0: no path, 1: valid but already present, 2: appended
+	std::vector<char> status(count, 0);
+	sharedPool().parallelCollect<reflectInfo>(count, 64, reflections, [&](int begin, int end, std::vector<reflectInfo>& out) {
+		std::vector<reflectInfo> path;
+		std::vector<unsigned int> key;
+		for (int i = begin; i < end; i++) {
+			if (!validate(scene, listener.pos, i, path))
+				continue;
+			status[i] = 1;
+			key.clear();
+			for (int h = 0; h < path.size(); h++)
+				key.push_back(path[h].hit.primitive);
+			if (existing.count(key) > 0)
+				continue;
+			out.insert(out.end(), path.begin(), path.end());
+			status[i] = 2;
+		}
+	});
+
+	lastValid = 0;
+	int appended = 0;
+	for (int i = 0; i < count; i++) {
+		lastValid += status[i] > 0 ? 1 : 0;
+		appended += status[i] == 2 ? 1 : 0;
+	}
+	return appended;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef IMAGESOURCE
+#define IMAGESOURCE
+#include <vector>
+
+#include <glm.hpp>
+
+#include "RayTracer.h"
+
+// an image closer than this to a reflecting plane is not mirrored across it
+#define IMAGE_PLANE_EPSILON 1e-4f
+
+// one mirrored copy of a sound source
+struct ImageNode {
+	glm::vec3	position;
+	int			triangle;	// reflector this image was mirrored across, -1 for the source itself
+	int			parent;		// image it was mirrored from, -1 for the source itself
+	int			source;		// index into Scene::getSpheres() of the source sphere
+	int			order;		// reflections on the path, 0 for the direct sound
+};
+
+/**
+ * deterministic early reflections by the image-source method
+ * every source sphere is mirrored across every triangle up to maxOrder times; images that can never
+ * form a path (mirrored across the same triangle twice, or whose parent reflector lies wholly behind
+ * the new one) are pruned while the tree is built
+ * the tree only depends on the geometry and is kept until the scene's version changes, so a static
+ * scene only pays for the visibility checks each frame
+ */
+class ImageSourceEngine {
+private:
+	int maxOrder;
+	int maxImages;
+	std::vector<ImageNode> images;
+	unsigned int sceneVersion = ~0u;	// version the tree was built from
+	bool built = false;
+	int lastValid = 0;
+
+	void build(const Scene& scene);
+	// fills path with the reflections from the listener to image, false if any leg misses its reflector or is blocked
+	bool validate(const Scene& scene, const glm::vec3& listener, int image, std::vector<reflectInfo>& path) const;
+public:
+	// trees stop growing at maxImages, the lowest orders are always complete first
+	ImageSourceEngine(int _maxOrder = 3, int _maxImages = 100000) : maxOrder(_maxOrder), maxImages(_maxImages) {}
+
+	void setMaxOrder(int order) { maxOrder = order; built = false; }
+	int getMaxOrder() const { return maxOrder; }
+
+	// rebuilds the image tree if the scene changed since the last call
+	void update(const Scene& scene);
+	/**
+	 * appends every specular path from the listener to a source of up to maxOrder reflections,
+	 * in the same form RayTracer() returns them: one reflectInfo per hit, ending on the source
+	 * paths that hit the same primitives as one already in reflections (found by a ray tracer) are skipped
+	 * returns the number of paths appended; the scene must not be edited while this runs
+	 */
+	int trace(const Scene& scene, const Listener& listener, std::vector<reflectInfo>& reflections);
+
+	int imageCount() const { return (int)images.size(); }
+	// valid paths in the last trace(), including the ones skipped as already present
+	int validCount() const { return lastValid; }
+};
+
+/**
+ * the one specular path from the listener that reflects on triangles in the given order (the first one
+ * is met first) and ends on the source sphere, found by mirroring the source back across them
+ * fills path like ImageSourceEngine::trace(), false if the path does not exist or is blocked
+ */
+bool SolveSpecularPath(const Scene& scene, const glm::vec3& listener, const std::vector<int>& triangles, int source, std::vector<reflectInfo>& path);
+#endif
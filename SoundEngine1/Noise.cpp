@@ -0,0 +1,128 @@
+#include "Noise.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISE_SSE2
+#include <emmintrin.h>
+#endif
+
+static uint64_t splitmix64(uint64_t& state) {
+	uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+static inline uint32_t rotl(uint32_t x, int k) {
+	return (x << k) | (x >> (32 - k));
+}
+
+//top 23 bits as the mantissa of a float in [1, 2), then moved to [-1, 1)
+static inline float bitsToUniform(uint32_t x) {
+	uint32_t bits = (x >> 9) | 0x3F800000u;
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f * 2.0f - 3.0f;
+}
+
+NoiseRNG::NoiseRNG(uint64_t seed) {
+	for (int lane = 0; lane < 4; lane++) {
+		for (int word = 0; word < 4; word += 2) {
+			uint64_t v = splitmix64(seed);
+			s[word][lane] = (uint32_t)v;
+			s[word + 1][lane] = (uint32_t)(v >> 32);
+		}
+	}
+}
+
+void NoiseRNG::uniform(float* out, int count) {
+	int i = 0;
+#ifdef NOISE_SSE2
+	__m128i s0 = _mm_loadu_si128((__m128i*)s[0]);
+	__m128i s1 = _mm_loadu_si128((__m128i*)s[1]);
+	__m128i s2 = _mm_loadu_si128((__m128i*)s[2]);
+	__m128i s3 = _mm_loadu_si128((__m128i*)s[3]);
+	const __m128i one = _mm_set1_epi32(0x3F800000);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 three = _mm_set1_ps(3.0f);
+	for (; i + 4 <= count; i += 4) {
+		__m128i result = _mm_add_epi32(s0, s3);
+		__m128i t = _mm_slli_epi32(s1, 9);
+		s2 = _mm_xor_si128(s2, s0);
+		s3 = _mm_xor_si128(s3, s1);
+		s1 = _mm_xor_si128(s1, s2);
+		s0 = _mm_xor_si128(s0, s3);
+		s2 = _mm_xor_si128(s2, t);
+		s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+		__m128 f = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(result, 9), one));
+		_mm_storeu_ps(out + i, _mm_sub_ps(_mm_mul_ps(f, two), three));
+	}
+	_mm_storeu_si128((__m128i*)s[0], s0);
+	_mm_storeu_si128((__m128i*)s[1], s1);
+	_mm_storeu_si128((__m128i*)s[2], s2);
+	_mm_storeu_si128((__m128i*)s[3], s3);
+#endif
+	//same step lane by lane. A partial step still advances all four lanes, the extra values are dropped
+	while (i < count) {
+		for (int lane = 0; lane < 4; lane++) {
+			uint32_t result = s[0][lane] + s[3][lane];
+			uint32_t t = s[1][lane] << 9;
+			s[2][lane] ^= s[0][lane];
+			s[3][lane] ^= s[1][lane];
+			s[1][lane] ^= s[2][lane];
+			s[0][lane] ^= s[3][lane];
+			s[2][lane] ^= t;
+			s[3][lane] = rotl(s[3][lane], 11);
+			if (i < count)
+				out[i++] = bitsToUniform(result);
+		}
+	}
+}
+
+NoiseGenerator::NoiseGenerator(NoiseColor _color, float _amplitude, uint64_t seed)
+	: rng(seed), color(_color), amplitude(_amplitude)
+{
+}
+
+void NoiseGenerator::fill(float* out, int count) {
+	rng.uniform(out, count);
+
+	switch (color) {
+	case NOISE_WHITE:
+		if (amplitude != 1)
+			for (int i = 0; i < count; i++)
+				out[i] *= amplitude;
+		break;
+	case NOISE_PINK: {
+		//http://www.firstpr.com.au/dsp/pink-noise/ (refined version), 0.11 brings it back near [-1, 1]
+		float b0 = pink[0], b1 = pink[1], b2 = pink[2], b3 = pink[3], b4 = pink[4], b5 = pink[5], b6 = pink[6];
+		float gain = 0.11f * amplitude;
+		for (int i = 0; i < count; i++) {
+			float white = out[i];
+			b0 = 0.99886f * b0 + white * 0.0555179f;
+			b1 = 0.99332f * b1 + white * 0.0750759f;
+			b2 = 0.96900f * b2 + white * 0.1538520f;
+			b3 = 0.86650f * b3 + white * 0.3104856f;
+			b4 = 0.55000f * b4 + white * 0.5329522f;
+			b5 = -0.7616f * b5 - white * 0.0168980f;
+			out[i] = (b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f) * gain;
+			b6 = white * 0.115926f;
+		}
+		pink[0] = b0; pink[1] = b1; pink[2] = b2; pink[3] = b3; pink[4] = b4; pink[5] = b5; pink[6] = b6;
+		break;
+	}
+	case NOISE_BROWN: {
+		//leaky integrator, the leak keeps it from wandering off to a DC offset
+		float b = brown;
+		float gain = 3.5f * amplitude;
+		for (int i = 0; i < count; i++) {
+			b = (b + 0.02f * out[i]) * (1.0f / 1.02f);
+			out[i] = b * gain;
+		}
+		brown = b;
+		break;
+	}
+	}
+}
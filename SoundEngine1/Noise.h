@@ -0,0 +1,46 @@
+#pragma once
+#ifndef NOISE
+#define NOISE
+#include <stdint.h>
+
+#include "Oscillators.h"
+
+enum NoiseColor {
+	NOISE_WHITE,	// flat spectrum
+	NOISE_PINK,		// -3 dB per octave
+	NOISE_BROWN		// -6 dB per octave
+};
+
+/**
+ * four interleaved xoshiro128+ generators, stepped together so every step is four SSE2 lanes
+ * seeded through splitmix64, so nearby seeds still give unrelated streams
+ */
+struct NoiseRNG {
+	uint32_t s[4][4];	// s[word][lane]
+
+	NoiseRNG(uint64_t seed = 0x9E3779B97F4A7C15ull);
+	// count uniform floats in [-1, 1)
+	void uniform(float* out, int count);
+};
+
+/**
+ * endless procedural noise, a few hundred bytes of state instead of a sample file
+ * pink uses Paul Kellet's refined filter and brown a leaky integrator, both on top of the white stream
+ */
+class NoiseGenerator : public Generator {
+private:
+	NoiseRNG rng;
+	NoiseColor color;
+	float amplitude;
+	float pink[7] = {};	// Kellet filter poles
+	float brown = 0;
+public:
+	NoiseGenerator(NoiseColor _color = NOISE_WHITE, float _amplitude = 1, uint64_t seed = 0x9E3779B97F4A7C15ull);
+
+	NoiseColor getColor() const { return color; }
+	void setAmplitude(float _amplitude) { amplitude = _amplitude; }
+
+	using Generator::fill;
+	void fill(float* out, int count);
+};
+#endif
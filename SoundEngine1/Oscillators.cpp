@@ -0,0 +1,193 @@
+#include "Oscillators.h"
+
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OSC_SSE2
+#include <emmintrin.h>
+#endif
+
+//samples are generated in blocks of this size so the phase ramp fits on the stack
+#define OSC_BLOCK 256
+
+#pragma region fastSin
+//odd Taylor terms of sin(2*pi*y) for |y| <= 1/4 (|2*pi*y| <= pi/2), error below 4e-6
+static const float S1 = 6.28318531f;
+static const float S3 = -41.3417022f;
+static const float S5 = 81.6052493f;
+static const float S7 = -76.7058597f;
+static const float S9 = 42.0586940f;
+
+static inline float sinCyclesScalar(float p) {
+	float x = p - floorf(p + 0.5f);			// [-0.5, 0.5)
+	float y = x;
+	if (x > 0.25f) y = 0.5f - x;			// sin(pi - a) = sin(a)
+	else if (x < -0.25f) y = -0.5f - x;
+	float y2 = y * y;
+	return y * (S1 + y2 * (S3 + y2 * (S5 + y2 * (S7 + y2 * S9))));
+}
+
+void fastSinCycles(const float* phase, float* out, int count) {
+	int i = 0;
+#ifdef OSC_SSE2
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 quarter = _mm_set1_ps(0.25f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	for (; i + 4 <= count; i += 4) {
+		__m128 p = _mm_loadu_ps(phase + i);
+		//x = p - round(p), round via truncation of p + 0.5 corrected for negatives
+		__m128 shifted = _mm_add_ps(p, half);
+		__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(shifted));
+		__m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmplt_ps(shifted, truncated), _mm_set1_ps(1.0f)));
+		__m128 x = _mm_sub_ps(p, floored);
+
+		//fold |x| > 1/4 back into [-1/4, 1/4]: y = sign(x) * 0.5 - x
+		__m128 sign = _mm_and_ps(x, signMask);
+		__m128 absX = _mm_andnot_ps(signMask, x);
+		__m128 folded = _mm_sub_ps(_mm_or_ps(half, sign), x);
+		__m128 fold = _mm_cmpgt_ps(absX, quarter);
+		__m128 y = _mm_or_ps(_mm_and_ps(fold, folded), _mm_andnot_ps(fold, x));
+
+		__m128 y2 = _mm_mul_ps(y, y);
+		__m128 r = _mm_set1_ps(S9);
+		r = _mm_add_ps(_mm_mul_ps(r, y2), _mm_set1_ps(S7));
+		r = _mm_add_ps(_mm_mul_ps(r, y2), _mm_set1_ps(S5));
+		r = _mm_add_ps(_mm_mul_ps(r, y2), _mm_set1_ps(S3));
+		r = _mm_add_ps(_mm_mul_ps(r, y2), _mm_set1_ps(S1));
+		_mm_storeu_ps(out + i, _mm_mul_ps(r, y));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = sinCyclesScalar(phase[i]);
+}
+
+void floatToPCM16(const float* in, short* out, int count, float gain) {
+	float scale = 32767.0f * gain;
+	int i = 0;
+#ifdef OSC_SSE2
+	const __m128 s = _mm_set1_ps(scale);
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), s));
+		__m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), s));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(lo, hi)); // saturates to [-32768, 32767]
+	}
+#endif
+	for (; i < count; i++) {
+		float v = in[i] * scale;
+		if (v > 32767.0f) v = 32767.0f;
+		if (v < -32768.0f) v = -32768.0f;
+		out[i] = (short)lrintf(v);
+	}
+}
+#pragma endregion fastSin
+
+void Generator::fill(short* out, int count) {
+	float block[OSC_BLOCK];
+
+	while (count > 0) {
+		int n = count < OSC_BLOCK ? count : OSC_BLOCK;
+		fill(block, n);
+		floatToPCM16(block, out, n);
+		out += n;
+		count -= n;
+	}
+}
+
+SineOscillator::SineOscillator(float _freq, unsigned int _sampleRate, float _amplitude)
+	: amplitude(_amplitude), sampleRate(_sampleRate)
+{
+	setFrequency(_freq);
+}
+
+void SineOscillator::setFrequency(float _freq) {
+	freq = _freq;
+	increment = double(freq) / sampleRate;
+}
+
+void SineOscillator::fill(float* out, int count) {
+	float ramp[OSC_BLOCK];
+
+	while (count > 0) {
+		int n = count < OSC_BLOCK ? count : OSC_BLOCK;
+
+		//the phase ramp restarts from the accumulator every block so float error cannot build up
+		float start = (float)phase;
+		float step = (float)increment;
+		for (int i = 0; i < n; i++)
+			ramp[i] = start + step * i;
+		fastSinCycles(ramp, out, n);
+		if (amplitude != 1)
+			for (int i = 0; i < n; i++)
+				out[i] *= amplitude;
+
+		phase += increment * n;
+		phase -= floor(phase);
+		out += n;
+		count -= n;
+	}
+}
+
+
+SweepOscillator::SweepOscillator(float _minFreq, float _maxFreq, float _sweepRate, unsigned int _sampleRate, float _amplitude)
+	: freq(_minFreq), amplitude(_amplitude), sampleRate(_sampleRate)
+{
+	setRange(_minFreq, _maxFreq);
+	setSweepRate(_sweepRate);
+}
+
+void SweepOscillator::setRange(float _minFreq, float _maxFreq) {
+	minFreq = _minFreq < _maxFreq ? _minFreq : _maxFreq;
+	maxFreq = _minFreq < _maxFreq ? _maxFreq : _minFreq;
+	if (freq < minFreq) freq = minFreq;
+	if (freq > maxFreq) freq = maxFreq;
+}
+
+void SweepOscillator::setSweepRate(float _sweepRate) {
+	double size = fabs(double(_sweepRate)) / sampleRate;
+	step = step < 0 ? -size : size; // keeps the current direction
+}
+
+void SweepOscillator::fill(float* out, int count) {
+	float ramp[OSC_BLOCK];
+
+	while (count > 0) {
+		int n = count < OSC_BLOCK ? count : OSC_BLOCK;
+
+		//a block is split wherever the sweep turns around, each piece has a linear frequency
+		int done = 0;
+		while (done < n) {
+			int m = n - done;
+			if (step != 0) {
+				//samples until the frequency leaves the range
+				double limit = step > 0 ? maxFreq : minFreq;
+				double left = floor((limit - freq) / step) + 1;
+				if (left < 1) left = 1;
+				if (left < m) m = (int)left;
+			}
+
+			//frequency f0 + step*i gives phase(i) = phase + (f0*i + step*i*(i-1)/2) / sampleRate
+			float start = (float)phase;
+			float a = float((freq - step * 0.5) / sampleRate);
+			float b = float(step * 0.5 / sampleRate);
+			for (int i = 0; i < m; i++)
+				ramp[done + i] = start + i * (a + b * i);
+
+			phase += (freq * m + step * 0.5 * m * (m - 1.0)) / sampleRate;
+			phase -= floor(phase);
+			freq += step * m;
+			if (freq > maxFreq || freq < minFreq) {
+				step = -step;
+				freq = freq > maxFreq ? maxFreq : minFreq;
+			}
+			done += m;
+		}
+
+		fastSinCycles(ramp, out, n);
+		if (amplitude != 1)
+			for (int i = 0; i < n; i++)
+				out[i] *= amplitude;
+
+		out += n;
+		count -= n;
+	}
+}
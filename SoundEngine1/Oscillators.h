@@ -0,0 +1,75 @@
+#pragma once
+#ifndef OSCILLATORS
+#define OSCILLATORS
+
+/**
+ * anything that produces an endless stream of mono samples in [-1, 1]
+ * fill() may run on OpenAL's mixer thread (see ProceduralSource.h), so it must not lock or allocate
+ */
+class Generator {
+public:
+	virtual ~Generator() {}
+	// writes count samples and advances the generator by count samples
+	virtual void fill(float* out, int count) = 0;
+	// same, converted to 16 bit PCM
+	void fill(short* out, int count);
+};
+
+/**
+ * sine oscillator with a persistent phase accumulator
+ * consecutive fill() calls continue exactly where the previous block ended,
+ * and nothing is allocated: the caller owns the output block
+ */
+class SineOscillator : public Generator {
+private:
+	double phase = 0;		// position within the current period, [0, 1)
+	double increment = 0;	// periods per sample
+	float freq;
+	float amplitude;
+	unsigned int sampleRate;
+public:
+	SineOscillator(float _freq = 440, unsigned int _sampleRate = 22050, float _amplitude = 1);
+
+	void setFrequency(float _freq);
+	void setAmplitude(float _amplitude) { amplitude = _amplitude; }
+	float getFrequency() const { return freq; }
+	unsigned int getSampleRate() const { return sampleRate; }
+	double getPhase() const { return phase; }
+	void reset(double _phase = 0) { phase = _phase; }
+
+	using Generator::fill;
+	void fill(float* out, int count);
+};
+
+/**
+ * sine whose frequency sweeps back and forth between minFreq and maxFreq (the SineWaveC demo)
+ * the phase is the exact running sum of the per-sample frequency, evaluated in closed form
+ * per block, so there is no loop-carried dependency and no drift between blocks
+ */
+class SweepOscillator : public Generator {
+private:
+	double phase = 0;		// position within the current period, [0, 1)
+	double freq;			// frequency of the next sample
+	double step = 0;		// Hz added per sample, negative while sweeping down
+	float minFreq, maxFreq;
+	float amplitude;
+	unsigned int sampleRate;
+public:
+	// sweepRate is in Hz per second; SineWaveC used 0.1 Hz per sample at 44.1 kHz
+	SweepOscillator(float _minFreq = 100, float _maxFreq = 5000, float _sweepRate = 4410, unsigned int _sampleRate = 44100, float _amplitude = 1);
+
+	void setRange(float _minFreq, float _maxFreq);
+	void setSweepRate(float _sweepRate);
+	void setAmplitude(float _amplitude) { amplitude = _amplitude; }
+	float getFrequency() const { return (float)freq; }
+	unsigned int getSampleRate() const { return sampleRate; }
+
+	using Generator::fill;
+	void fill(float* out, int count);
+};
+
+// sin(2*pi*phase) for each phase, vectorized polynomial approximation (max error ~4e-6)
+void fastSinCycles(const float* phase, float* out, int count);
+// converts [-1, 1] floats to 16 bit PCM with saturation
+void floatToPCM16(const float* in, short* out, int count, float gain = 1);
+#endif
@@ -0,0 +1,111 @@
+#include "ProceduralSource.h"
+#include "ALPool.h"
+
+#include <stdio.h>
+
+static LPALBUFFERCALLBACKSOFT bufferCallback = NULL;
+
+bool callbackBuffersSupported() {
+	static bool checked = false;
+	if (!checked) {
+		checked = true;
+		if (alIsExtensionPresent("AL_SOFT_callback_buffer"))
+			bufferCallback = (LPALBUFFERCALLBACKSOFT)alGetProcAddress("alBufferCallbackSOFT");
+		if (bufferCallback == NULL)
+			printf("AL_SOFT_callback_buffer not supported, procedural sources use queued buffers\n");
+	}
+	return bufferCallback != NULL;
+}
+
+//runs on the mixer thread whenever it needs more samples
+ALsizei AL_APIENTRY ProceduralSource::pullSamples(ALvoid* userptr, ALvoid* sampledata, ALsizei numbytes) AL_API_NOEXCEPT17 {
+	ProceduralSource* self = (ProceduralSource*)userptr;
+	int count = numbytes / (int)sizeof(short);
+	self->generator->fill((short*)sampledata, count);
+	return count * (int)sizeof(short);
+}
+
+ProceduralSource::ProceduralSource(Generator* _generator, unsigned int _sampleRate)
+	: generator(_generator), sampleRate(_sampleRate)
+{
+	sourceid = sourcePool().acquire();
+	callbackMode = callbackBuffersSupported();
+
+	if (callbackMode) {
+		bufferCount = 1;
+		buffers[0] = bufferPool().acquire();
+		bufferCallback(buffers[0], AL_FORMAT_MONO16, sampleRate, pullSamples, this);
+		alSourcei(sourceid, AL_BUFFER, buffers[0]);
+	}
+	else {
+		bufferCount = PROCEDURAL_BUFFER_COUNT;
+		for (int i = 0; i < bufferCount; i++)
+			buffers[i] = bufferPool().acquire();
+		scratch = new short[PROCEDURAL_BUFFER_SAMPLES];
+	}
+}
+
+ProceduralSource::~ProceduralSource() {
+	close();
+}
+
+void ProceduralSource::queueBuffer(unsigned int bufferid) {
+	generator->fill(scratch, PROCEDURAL_BUFFER_SAMPLES);
+	alBufferData(bufferid, AL_FORMAT_MONO16, scratch, PROCEDURAL_BUFFER_SAMPLES * sizeof(short), sampleRate);
+	alSourceQueueBuffers(sourceid, 1, &bufferid);
+}
+
+void ProceduralSource::play() {
+	if (sourceid == 0)
+		return;
+
+	if (!callbackMode) {
+		alSourceStop(sourceid);
+		alSourcei(sourceid, AL_BUFFER, 0);
+		for (int i = 0; i < bufferCount; i++)
+			queueBuffer(buffers[i]);
+	}
+	alSourcePlay(sourceid);
+	playing = true;
+}
+
+void ProceduralSource::stop() {
+	playing = false;
+	if (sourceid != 0)
+		alSourceStop(sourceid);
+}
+
+void ProceduralSource::update() {
+	if (callbackMode || sourceid == 0)
+		return;
+
+	int processed = 0;
+	alGetSourcei(sourceid, AL_BUFFERS_PROCESSED, &processed);
+	while (processed-- > 0) {
+		unsigned int bufferid;
+		alSourceUnqueueBuffers(sourceid, 1, &bufferid);
+		queueBuffer(bufferid);
+	}
+
+	//a long frame can drain the ring; the refilled buffers only play once the source is restarted
+	int state;
+	alGetSourcei(sourceid, AL_SOURCE_STATE, &state);
+	if (playing && state == AL_STOPPED)
+		alSourcePlay(sourceid);
+}
+
+void ProceduralSource::close() {
+	if (sourceid == 0)
+		return;
+
+	//the source lets go of the buffers (and with them the callback) before they go back to the pool
+	sourcePool().release(sourceid);
+	for (int i = 0; i < bufferCount; i++)
+		bufferPool().release(buffers[i]);
+	sourceid = 0;
+	bufferCount = 0;
+	playing = false;
+
+	delete[] scratch;
+	scratch = NULL;
+}
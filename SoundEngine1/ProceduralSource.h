@@ -0,0 +1,53 @@
+#pragma once
+#ifndef PROCEDURALSOURCE
+#define PROCEDURALSOURCE
+#include <AL/al.h>
+#include <AL/alc.h>
+#include <AL/alext.h>
+
+#include "Oscillators.h"
+
+// fallback ring used when AL_SOFT_callback_buffer is missing
+#define PROCEDURAL_BUFFER_COUNT 4
+#define PROCEDURAL_BUFFER_SAMPLES 2048
+
+/**
+ * mono 16 bit source whose samples are pulled from a Generator on demand
+ * with AL_SOFT_callback_buffer the mixer calls the generator directly, so there is
+ * nothing to refill, stop or regenerate; without it a small queued ring is topped up by update()
+ * the generator must stay alive, and must not be touched by other threads, while the source plays
+ */
+class ProceduralSource {
+private:
+	Generator* generator;
+	unsigned int sampleRate;
+	unsigned int sourceid = 0;
+	unsigned int buffers[PROCEDURAL_BUFFER_COUNT] = {};
+	int bufferCount = 0;		// 1 in callback mode, PROCEDURAL_BUFFER_COUNT otherwise
+	bool callbackMode = false;
+	bool playing = false;		// between play() and stop(), used to restart a starved fallback ring
+	short* scratch = NULL;		// fallback mode only
+
+	static ALsizei AL_APIENTRY pullSamples(ALvoid* userptr, ALvoid* sampledata, ALsizei numbytes) AL_API_NOEXCEPT17;
+	void queueBuffer(unsigned int bufferid);
+public:
+	// takes a source and buffer(s) from the global pools
+	ProceduralSource(Generator* _generator, unsigned int _sampleRate);
+	~ProceduralSource();
+	ProceduralSource(const ProceduralSource&) = delete;
+	ProceduralSource& operator=(const ProceduralSource&) = delete;
+
+	unsigned int getSource() const { return sourceid; }
+	bool usesCallback() const { return callbackMode; }
+
+	void play();
+	void stop();
+	// keeps the fallback ring filled; does nothing in callback mode. Call once per frame
+	void update();
+	// hands everything back to the pools. Must run before freeALPools()
+	void close();
+};
+
+// true if the current context supports AL_SOFT_callback_buffer
+bool callbackBuffersSupported();
+#endif
@@ -0,0 +1,307 @@
+#include "RayKernels.h"
+
+#include <math.h>
+#include <float.h>
+
+#define SDL_MAIN_HANDLED
+#include <SDL/SDL.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RAY_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+//GCC and Clang only emit SSE4.1/AVX2 instructions inside functions marked for them; MSVC always does
+#if defined(__GNUC__) || defined(__clang__)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+#pragma region scalar
+static int trianglesScalar(const KernelRay& ray, const TriangleSoA& tris, int first, int count, float& t) {
+	int best = -1;
+	for (int i = first; i < first + count; i++) {
+		float e1x = tris.e1[0][i], e1y = tris.e1[1][i], e1z = tris.e1[2][i];
+		float e2x = tris.e2[0][i], e2y = tris.e2[1][i], e2z = tris.e2[2][i];
+		float hx = ray.dy * e2z - ray.dz * e2y, hy = ray.dz * e2x - ray.dx * e2z, hz = ray.dx * e2y - ray.dy * e2x;
+		float a = e1x * hx + e1y * hy + e1z * hz;
+		if (a > -1e-7f && a < 1e-7f)
+			continue;
+
+		float f = 1.0f / a;
+		float sx = ray.ox - tris.v0[0][i], sy = ray.oy - tris.v0[1][i], sz = ray.oz - tris.v0[2][i];
+		float u = f * (sx * hx + sy * hy + sz * hz);
+		if (u < 0.0f || u > 1.0f)
+			continue;
+
+		float qx = sy * e1z - sz * e1y, qy = sz * e1x - sx * e1z, qz = sx * e1y - sy * e1x;
+		float v = f * (ray.dx * qx + ray.dy * qy + ray.dz * qz);
+		if (v < 0.0f || u + v > 1.0f)
+			continue;
+
+		float d = f * (e2x * qx + e2y * qy + e2z * qz);
+		if (d > 1e-7f && d < t) {
+			t = d;
+			best = i;
+		}
+	}
+	return best;
+}
+
+static int spheresScalar(const KernelRay& ray, const SphereSoA& spheres, int first, int count, float& t) {
+	int best = -1;
+	for (int i = first; i < first + count; i++) {
+		float ocx = ray.ox - spheres.center[0][i], ocy = ray.oy - spheres.center[1][i], ocz = ray.oz - spheres.center[2][i];
+		float b = ray.dx * ocx + ray.dy * ocy + ray.dz * ocz;
+		float oc2 = ocx * ocx + ocy * ocy + ocz * ocz;
+		float r2 = spheres.radius[i] * spheres.radius[i];
+		float discriminant = b * b - ray.dd * (oc2 - r2);
+		if (discriminant < 0.0f)
+			continue;
+
+		//from outside the near side faces the ray, from inside the far side does
+		float root = sqrtf(discriminant);
+		float d = (oc2 > r2 ? -b - root : -b + root) / ray.dd;
+		if (d > 0.0f && d < t) {
+			t = d;
+			best = i;
+		}
+	}
+	return best;
+}
+#pragma endregion scalar
+
+#ifdef RAY_KERNELS_X86
+#pragma region SSE41
+KERNEL_TARGET("sse4.1") static int trianglesSSE41(const KernelRay& ray, const TriangleSoA& tris, int first, int count, float& t) {
+	const __m128 dx = _mm_set1_ps(ray.dx), dy = _mm_set1_ps(ray.dy), dz = _mm_set1_ps(ray.dz);
+	const __m128 ox = _mm_set1_ps(ray.ox), oy = _mm_set1_ps(ray.oy), oz = _mm_set1_ps(ray.oz);
+	const __m128 eps = _mm_set1_ps(1e-7f), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 bestT = _mm_set1_ps(t);
+	__m128i bestIndex = _mm_set1_epi32(-1);
+	__m128i index = _mm_add_epi32(_mm_set1_epi32(first), _mm_setr_epi32(0, 1, 2, 3));
+	const __m128i end = _mm_set1_epi32(first + count);
+
+	for (int i = first; i < first + count; i += 4) {
+		__m128 v0x = _mm_loadu_ps(tris.v0[0] + i), v0y = _mm_loadu_ps(tris.v0[1] + i), v0z = _mm_loadu_ps(tris.v0[2] + i);
+		__m128 e1x = _mm_loadu_ps(tris.e1[0] + i), e1y = _mm_loadu_ps(tris.e1[1] + i), e1z = _mm_loadu_ps(tris.e1[2] + i);
+		__m128 e2x = _mm_loadu_ps(tris.e2[0] + i), e2y = _mm_loadu_ps(tris.e2[1] + i), e2z = _mm_loadu_ps(tris.e2[2] + i);
+
+		__m128 hx = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+		__m128 hy = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+		__m128 hz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+		__m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, hx), _mm_mul_ps(e1y, hy)), _mm_mul_ps(e1z, hz));
+		__m128 f = _mm_div_ps(one, a);
+
+		__m128 sx = _mm_sub_ps(ox, v0x), sy = _mm_sub_ps(oy, v0y), sz = _mm_sub_ps(oz, v0z);
+		__m128 u = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, hx), _mm_mul_ps(sy, hy)), _mm_mul_ps(sz, hz)));
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+		__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+		__m128 v = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)));
+		__m128 d = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)));
+
+		__m128 hit = _mm_cmpge_ps(_mm_andnot_ps(signMask, a), eps);
+		hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+		hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+		hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(d, eps), _mm_cmplt_ps(d, bestT)));
+		hit = _mm_and_ps(hit, _mm_castsi128_ps(_mm_cmplt_epi32(index, end))); // lanes past the run
+
+		bestT = _mm_blendv_ps(bestT, d, hit);
+		bestIndex = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(bestIndex), _mm_castsi128_ps(index), hit));
+		index = _mm_add_epi32(index, _mm_set1_epi32(4));
+	}
+
+	float lanesT[4];
+	int lanesIndex[4];
+	_mm_storeu_ps(lanesT, bestT);
+	_mm_storeu_si128((__m128i*)lanesIndex, bestIndex);
+	int best = -1;
+	for (int l = 0; l < 4; l++) {
+		if (lanesIndex[l] >= 0 && (lanesT[l] < t || (lanesT[l] == t && lanesIndex[l] < best))) {
+			t = lanesT[l];
+			best = lanesIndex[l];
+		}
+	}
+	return best;
+}
+
+KERNEL_TARGET("sse4.1") static int spheresSSE41(const KernelRay& ray, const SphereSoA& spheres, int first, int count, float& t) {
+	const __m128 dx = _mm_set1_ps(ray.dx), dy = _mm_set1_ps(ray.dy), dz = _mm_set1_ps(ray.dz);
+	const __m128 ox = _mm_set1_ps(ray.ox), oy = _mm_set1_ps(ray.oy), oz = _mm_set1_ps(ray.oz);
+	const __m128 dd = _mm_set1_ps(ray.dd), zero = _mm_setzero_ps();
+	__m128 bestT = _mm_set1_ps(t);
+	__m128i bestIndex = _mm_set1_epi32(-1);
+	__m128i index = _mm_add_epi32(_mm_set1_epi32(first), _mm_setr_epi32(0, 1, 2, 3));
+	const __m128i end = _mm_set1_epi32(first + count);
+
+	for (int i = first; i < first + count; i += 4) {
+		__m128 ocx = _mm_sub_ps(ox, _mm_loadu_ps(spheres.center[0] + i));
+		__m128 ocy = _mm_sub_ps(oy, _mm_loadu_ps(spheres.center[1] + i));
+		__m128 ocz = _mm_sub_ps(oz, _mm_loadu_ps(spheres.center[2] + i));
+		__m128 r = _mm_loadu_ps(spheres.radius + i);
+		__m128 r2 = _mm_mul_ps(r, r);
+		__m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, ocx), _mm_mul_ps(dy, ocy)), _mm_mul_ps(dz, ocz));
+		__m128 oc2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz));
+		__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(dd, _mm_sub_ps(oc2, r2)));
+
+		__m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+		__m128 nearRoot = _mm_sub_ps(_mm_sub_ps(zero, b), root);
+		__m128 farRoot = _mm_add_ps(_mm_sub_ps(zero, b), root);
+		__m128 d = _mm_div_ps(_mm_blendv_ps(farRoot, nearRoot, _mm_cmpgt_ps(oc2, r2)), dd);
+
+		__m128 hit = _mm_cmpge_ps(discriminant, zero);
+		hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(d, zero), _mm_cmplt_ps(d, bestT)));
+		hit = _mm_and_ps(hit, _mm_castsi128_ps(_mm_cmplt_epi32(index, end)));
+
+		bestT = _mm_blendv_ps(bestT, d, hit);
+		bestIndex = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(bestIndex), _mm_castsi128_ps(index), hit));
+		index = _mm_add_epi32(index, _mm_set1_epi32(4));
+	}
+
+	float lanesT[4];
+	int lanesIndex[4];
+	_mm_storeu_ps(lanesT, bestT);
+	_mm_storeu_si128((__m128i*)lanesIndex, bestIndex);
+	int best = -1;
+	for (int l = 0; l < 4; l++) {
+		if (lanesIndex[l] >= 0 && (lanesT[l] < t || (lanesT[l] == t && lanesIndex[l] < best))) {
+			t = lanesT[l];
+			best = lanesIndex[l];
+		}
+	}
+	return best;
+}
+#pragma endregion SSE41
+
+#pragma region AVX2
+KERNEL_TARGET("avx2") static int trianglesAVX2(const KernelRay& ray, const TriangleSoA& tris, int first, int count, float& t) {
+	const __m256 dx = _mm256_set1_ps(ray.dx), dy = _mm256_set1_ps(ray.dy), dz = _mm256_set1_ps(ray.dz);
+	const __m256 ox = _mm256_set1_ps(ray.ox), oy = _mm256_set1_ps(ray.oy), oz = _mm256_set1_ps(ray.oz);
+	const __m256 eps = _mm256_set1_ps(1e-7f), zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	__m256 bestT = _mm256_set1_ps(t);
+	__m256i bestIndex = _mm256_set1_epi32(-1);
+	__m256i index = _mm256_add_epi32(_mm256_set1_epi32(first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	const __m256i end = _mm256_set1_epi32(first + count);
+
+	for (int i = first; i < first + count; i += 8) {
+		__m256 v0x = _mm256_loadu_ps(tris.v0[0] + i), v0y = _mm256_loadu_ps(tris.v0[1] + i), v0z = _mm256_loadu_ps(tris.v0[2] + i);
+		__m256 e1x = _mm256_loadu_ps(tris.e1[0] + i), e1y = _mm256_loadu_ps(tris.e1[1] + i), e1z = _mm256_loadu_ps(tris.e1[2] + i);
+		__m256 e2x = _mm256_loadu_ps(tris.e2[0] + i), e2y = _mm256_loadu_ps(tris.e2[1] + i), e2z = _mm256_loadu_ps(tris.e2[2] + i);
+
+		__m256 hx = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+		__m256 hy = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+		__m256 hz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+		__m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, hx), _mm256_mul_ps(e1y, hy)), _mm256_mul_ps(e1z, hz));
+		__m256 f = _mm256_div_ps(one, a);
+
+		__m256 sx = _mm256_sub_ps(ox, v0x), sy = _mm256_sub_ps(oy, v0y), sz = _mm256_sub_ps(oz, v0z);
+		__m256 u = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, hx), _mm256_mul_ps(sy, hy)), _mm256_mul_ps(sz, hz)));
+		__m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+		__m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+		__m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+		__m256 v = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)));
+		__m256 d = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)));
+
+		__m256 hit = _mm256_cmp_ps(_mm256_andnot_ps(signMask, a), eps, _CMP_GE_OQ);
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(d, eps, _CMP_GT_OQ), _mm256_cmp_ps(d, bestT, _CMP_LT_OQ)));
+		hit = _mm256_and_ps(hit, _mm256_castsi256_ps(_mm256_cmpgt_epi32(end, index))); // lanes past the run
+
+		bestT = _mm256_blendv_ps(bestT, d, hit);
+		bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), hit));
+		index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+	}
+
+	float lanesT[8];
+	int lanesIndex[8];
+	_mm256_storeu_ps(lanesT, bestT);
+	_mm256_storeu_si256((__m256i*)lanesIndex, bestIndex);
+	int best = -1;
+	for (int l = 0; l < 8; l++) {
+		if (lanesIndex[l] >= 0 && (lanesT[l] < t || (lanesT[l] == t && lanesIndex[l] < best))) {
+			t = lanesT[l];
+			best = lanesIndex[l];
+		}
+	}
+	return best;
+}
+
+KERNEL_TARGET("avx2") static int spheresAVX2(const KernelRay& ray, const SphereSoA& spheres, int first, int count, float& t) {
+	const __m256 dx = _mm256_set1_ps(ray.dx), dy = _mm256_set1_ps(ray.dy), dz = _mm256_set1_ps(ray.dz);
+	const __m256 ox = _mm256_set1_ps(ray.ox), oy = _mm256_set1_ps(ray.oy), oz = _mm256_set1_ps(ray.oz);
+	const __m256 dd = _mm256_set1_ps(ray.dd), zero = _mm256_setzero_ps();
+	__m256 bestT = _mm256_set1_ps(t);
+	__m256i bestIndex = _mm256_set1_epi32(-1);
+	__m256i index = _mm256_add_epi32(_mm256_set1_epi32(first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	const __m256i end = _mm256_set1_epi32(first + count);
+
+	for (int i = first; i < first + count; i += 8) {
+		__m256 ocx = _mm256_sub_ps(ox, _mm256_loadu_ps(spheres.center[0] + i));
+		__m256 ocy = _mm256_sub_ps(oy, _mm256_loadu_ps(spheres.center[1] + i));
+		__m256 ocz = _mm256_sub_ps(oz, _mm256_loadu_ps(spheres.center[2] + i));
+		__m256 r = _mm256_loadu_ps(spheres.radius + i);
+		__m256 r2 = _mm256_mul_ps(r, r);
+		__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, ocx), _mm256_mul_ps(dy, ocy)), _mm256_mul_ps(dz, ocz));
+		__m256 oc2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz));
+		__m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(dd, _mm256_sub_ps(oc2, r2)));
+
+		__m256 root = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+		__m256 nearRoot = _mm256_sub_ps(_mm256_sub_ps(zero, b), root);
+		__m256 farRoot = _mm256_add_ps(_mm256_sub_ps(zero, b), root);
+		__m256 d = _mm256_div_ps(_mm256_blendv_ps(farRoot, nearRoot, _mm256_cmp_ps(oc2, r2, _CMP_GT_OQ)), dd);
+
+		__m256 hit = _mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ);
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(d, zero, _CMP_GT_OQ), _mm256_cmp_ps(d, bestT, _CMP_LT_OQ)));
+		hit = _mm256_and_ps(hit, _mm256_castsi256_ps(_mm256_cmpgt_epi32(end, index)));
+
+		bestT = _mm256_blendv_ps(bestT, d, hit);
+		bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), hit));
+		index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+	}
+
+	float lanesT[8];
+	int lanesIndex[8];
+	_mm256_storeu_ps(lanesT, bestT);
+	_mm256_storeu_si256((__m256i*)lanesIndex, bestIndex);
+	int best = -1;
+	for (int l = 0; l < 8; l++) {
+		if (lanesIndex[l] >= 0 && (lanesT[l] < t || (lanesT[l] == t && lanesIndex[l] < best))) {
+			t = lanesT[l];
+			best = lanesIndex[l];
+		}
+	}
+	return best;
+}
+#pragma endregion AVX2
+#endif
+
+RayKernels rayKernels(RayKernelLevel level) {
+	RayKernels k = { KERNEL_SCALAR, trianglesScalar, spheresScalar };
+#ifdef RAY_KERNELS_X86
+	if (level >= KERNEL_AVX2 && SDL_HasAVX2()) {
+		k = { KERNEL_AVX2, trianglesAVX2, spheresAVX2 };
+	}
+	else if (level >= KERNEL_SSE41 && SDL_HasSSE41()) {
+		k = { KERNEL_SSE41, trianglesSSE41, spheresSSE41 };
+	}
+#endif
+	return k;
+}
+
+const RayKernels& rayKernels() {
+	static const RayKernels detected = rayKernels(KERNEL_AVX2);
+	return detected;
+}
+
+const char* rayKernelName(RayKernelLevel level) {
+	switch (level) {
+	case KERNEL_AVX2: return "AVX2";
+	case KERNEL_SSE41: return "SSE4.1";
+	default: return "scalar";
+	}
+}
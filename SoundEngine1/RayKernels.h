@@ -0,0 +1,56 @@
+#pragma once
+#ifndef RAYKERNELS
+#define RAYKERNELS
+#include <vector>
+
+// SoA arrays are padded by this many elements, so a kernel may read a full vector past the last primitive
+#define RAY_KERNEL_PAD 8
+
+// instruction sets a kernel can be built for, picked once at runtime
+enum RayKernelLevel {
+	KERNEL_SCALAR,
+	KERNEL_SSE41,	// 4 primitives per step
+	KERNEL_AVX2		// 8 primitives per step
+};
+
+// one ray in the form the kernels want it
+struct KernelRay {
+	float ox, oy, oz;
+	float dx, dy, dz;
+	float dd;	// dot(dir, dir), the rays are not normalized
+};
+
+// triangles as separate coordinate arrays, one element per triangle (see TriangleStore.h)
+struct TriangleSoA {
+	const float* v0[3];
+	const float* e1[3];	// v1 - v0
+	const float* e2[3];	// v2 - v0
+};
+
+// spheres as separate arrays, one element per sphere
+struct SphereSoA {
+	const float* center[3];
+	const float* radius;
+};
+
+/**
+ * one ray against a run of primitives [first, first + count)
+ * returns the index of the closest hit nearer than t and writes its distance to t, or -1 if none is nearer
+ * hits follow the scalar tests in RayTracer.cpp exactly: same epsilons, and a ray that starts
+ * inside a sphere hits its far side
+ */
+typedef int (*TriangleKernel)(const KernelRay& ray, const TriangleSoA& tris, int first, int count, float& t);
+typedef int (*SphereKernel)(const KernelRay& ray, const SphereSoA& spheres, int first, int count, float& t);
+
+struct RayKernels {
+	RayKernelLevel level;
+	TriangleKernel triangles;
+	SphereKernel spheres;
+};
+
+// the widest kernels this CPU runs (SDL_HasAVX2 / SDL_HasSSE41), detected on first use
+const RayKernels& rayKernels();
+// kernels of one particular level, falls back to narrower ones the CPU or compiler lacks
+RayKernels rayKernels(RayKernelLevel level);
+const char* rayKernelName(RayKernelLevel level);
+#endif
@@ -0,0 +1,133 @@
+#include "RaySampling.h"
+#include "CounterRNG.h"
+
+#include <math.h>
+#include <algorithm>
+
+static const float PI = 3.14159265358979f;
+
+glm::vec3 SquareToSphere(float u, float v) {
+	//Archimedes: z uniform in [-1, 1] is uniform over the sphere's area
+	float z = 1 - 2 * u;
+	float r = sqrtf(std::max(0.0f, 1 - z * z));
+	float phi = 2 * PI * v;
+	return glm::vec3(r * cosf(phi), r * sinf(phi), z);
+}
+
+SampleRotation RandomRotation(uint64_t frame) {
+	RayRandom rng(frame, RNG_BATCH_RAY);
+	float u1 = rng.uniform01(), u2 = rng.uniform01(), u3 = rng.uniform01();
+	float a = sqrtf(1 - u1), b = sqrtf(u1);
+	float qx = a * sinf(2 * PI * u2), qy = a * cosf(2 * PI * u2);
+	float qz = b * sinf(2 * PI * u3), qw = b * cosf(2 * PI * u3);
+
+	SampleRotation rot;
+	rot.x = glm::vec3(1 - 2 * (qy * qy + qz * qz), 2 * (qx * qy + qw * qz), 2 * (qx * qz - qw * qy));
+	rot.y = glm::vec3(2 * (qx * qy - qw * qz), 1 - 2 * (qx * qx + qz * qz), 2 * (qy * qz + qw * qx));
+	rot.z = glm::vec3(2 * (qx * qz + qw * qy), 2 * (qy * qz - qw * qx), 1 - 2 * (qx * qx + qy * qy));
+	return rot;
+}
+
+#pragma region Sobol
+// second Sobol dimension (primitive polynomial x + 1), the first one is the bit reversed index
+static uint32_t sobolDimension1(uint32_t index) {
+	uint32_t result = 0;
+	uint32_t v = 1u << 31;
+	for (; index != 0; index >>= 1, v ^= v >> 1) {
+		if (index & 1)
+			result ^= v;
+	}
+	return result;
+}
+
+static uint32_t reverseBits(uint32_t x) {
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+	x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+	return (x >> 16) | (x << 16);
+}
+#pragma endregion Sobol
+
+void GenerateDirections(RaySampling scheme, int count, uint64_t frame, std::vector<glm::vec3>& dirs) {
+	dirs.resize(std::max(count, 0));
+	if (count <= 0)
+		return;
+
+	switch (scheme) {
+	case SAMPLING_CUBE:
+		for (int i = 0; i < count; i++) {
+			RayRandom rng(frame, i);
+			glm::vec3 d;
+			for (int axis = 0; axis < 3; axis++)	//one at a time, argument order is unspecified
+				d[axis] = rng.uniform();
+			float len = glm::length(d);
+			dirs[i] = len > 0 ? d / len : glm::vec3(0, 0, 1);
+		}
+		return;	//no rotation, this is the biased reference
+
+	case SAMPLING_RANDOM:
+		for (int i = 0; i < count; i++) {
+			RayRandom rng(frame, i);
+			float u = rng.uniform01();
+			dirs[i] = SquareToSphere(u, rng.uniform01());
+		}
+		return;	//already isotropic
+
+	case SAMPLING_STRATIFIED: {
+		//rows of cells in the unit square, row heights follow the cells per row so every cell has area 1/count
+		int rows = std::max(1, (int)sqrtf((float)count));
+		int i = 0;
+		for (int row = 0; row < rows; row++) {
+			int begin = (int)((long long)count * row / rows);
+			int end = (int)((long long)count * (row + 1) / rows);
+			int cells = end - begin;
+			for (int c = 0; c < cells; c++, i++) {
+				RayRandom rng(frame, i);
+				float u = (begin + cells * rng.uniform01()) / count;
+				float v = (c + rng.uniform01()) / cells;
+				dirs[i] = SquareToSphere(u, v);
+			}
+		}
+		break;
+	}
+
+	case SAMPLING_FIBONACCI: {
+		const float goldenAngle = PI * (3 - sqrtf(5.0f));
+		for (int i = 0; i < count; i++) {
+			float z = 1 - (2 * i + 1) / (float)count;
+			float r = sqrtf(std::max(0.0f, 1 - z * z));
+			float phi = goldenAngle * i;
+			dirs[i] = glm::vec3(r * cosf(phi), r * sinf(phi), z);
+		}
+		break;
+	}
+
+	case SAMPLING_SOBOL: {
+		//a random XOR of every digit keeps the net properties and decorrelates frames (second batch stream, the first is the rotation)
+		RayRandom rng(frame, RNG_BATCH_RAY, 1);
+		uint32_t shiftU = rng.next(), shiftV = rng.next();
+		for (int i = 0; i < count; i++) {
+			uint32_t u = reverseBits((uint32_t)i) ^ shiftU;
+			uint32_t v = sobolDimension1((uint32_t)i) ^ shiftV;
+			dirs[i] = SquareToSphere((u >> 8) * (1.0f / 16777216.0f), (v >> 8) * (1.0f / 16777216.0f));
+		}
+		break;
+	}
+	}
+
+	SampleRotation rot = RandomRotation(frame);
+	for (int i = 0; i < count; i++)
+		dirs[i] = glm::normalize(rot.apply(dirs[i]));
+}
+
+const char* raySamplingName(RaySampling scheme) {
+	switch (scheme) {
+	case SAMPLING_CUBE:			return "cube";
+	case SAMPLING_RANDOM:		return "random";
+	case SAMPLING_STRATIFIED:	return "stratified";
+	case SAMPLING_FIBONACCI:	return "fibonacci";
+	case SAMPLING_SOBOL:		return "sobol";
+	}
+	return "unknown";
+}
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef RAYSAMPLING
+#define RAYSAMPLING
+#include <vector>
+#include <stdint.h>
+
+#include <glm.hpp>
+
+// ways of spreading a batch of ray directions over the sphere
+enum RaySampling {
+	SAMPLING_CUBE,			// each component uniform in [-1, 1), the old GetRandomRay. Biased toward the cube corners
+	SAMPLING_RANDOM,		// independent uniform directions
+	SAMPLING_STRATIFIED,	// one jittered direction per equal area cell
+	SAMPLING_FIBONACCI,		// Fibonacci sphere, the most even spread for a given count
+	SAMPLING_SOBOL			// first two Sobol dimensions with a random digital shift, any prefix is well spread
+};
+
+// random rotation applied to a whole direction set, so a fixed pattern does not alias with the geometry
+struct SampleRotation {
+	glm::vec3 x, y, z;	// columns of the rotation matrix
+
+	SampleRotation() : x(1, 0, 0), y(0, 1, 0), z(0, 0, 1) {}
+	glm::vec3 apply(const glm::vec3& d) const { return x * d.x + y * d.y + z * d.z; }
+};
+
+// uniformly distributed rotation (Shoemake's random unit quaternion) for one frame
+SampleRotation RandomRotation(uint64_t frame);
+
+/**
+ * count unit directions, uniform over the sphere in expectation for every scheme but SAMPLING_CUBE
+ * every random draw is keyed by (frame, ray index) through RayRandom (see CounterRNG.h), so a frame
+ * always gives the same set and each frame a fresh rotation, jitter and scramble
+ * replaces the contents of dirs
+ */
+void GenerateDirections(RaySampling scheme, int count, uint64_t frame, std::vector<glm::vec3>& dirs);
+
+// direction on the unit sphere for a point of the unit square, preserves area
+glm::vec3 SquareToSphere(float u, float v);
+
+const char* raySamplingName(RaySampling scheme);
+#endif
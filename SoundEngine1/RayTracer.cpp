@@ -0,0 +1,307 @@
+#include "RayTracer.h"
+#include "ThreadPool.h"
+#include "CounterRNG.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#pragma region Scene
+int Scene::addMaterial(Material mtl) {
+	if (materials.size() >= TRIANGLE_MAX_MATERIALS) {
+		fprintf(stderr, "addMaterial: scene already has %i materials\n", TRIANGLE_MAX_MATERIALS);
+		return -1;
+	}
+	materials.push_back(mtl);
+	version++;
+	return (int)materials.size() - 1;
+}
+
+int Scene::addSphere(const Sphere& sphere) {
+	spheres.push_back(sphere);
+	version++;
+	return (int)spheres.size() - 1;
+}
+
+int Scene::addTriangle(const Triangle& triangle) {
+	if (triangle.material < 0 || triangle.material >= (int)materials.size()) {
+		fprintf(stderr, "addTriangle: material %i does not exist\n", triangle.material);
+		return -1;
+	}
+	version++;
+	triangleVersion++;
+	return triangles.add(triangle);
+}
+
+void Scene::setSphere(int index, const Sphere& sphere) {
+	if (spheres[index].material != sphere.material)
+		sphereVersion++;
+	spheres[index] = sphere;
+	version++;
+}
+
+void Scene::removeSphere(int index) {
+	spheres[index] = spheres.back();
+	spheres.pop_back();
+	version++;
+	sphereVersion++;
+}
+
+void Scene::removeTriangle(int index) {
+	triangles.remove(index);
+	version++;
+	triangleVersion++;
+}
+
+void Scene::buildBVH() {
+	bvh.build(*this);
+	bvhVersion = version;
+}
+
+void Scene::clear() {
+	spheres.clear();
+	triangles.clear();
+	version++;
+	triangleVersion++;
+	sphereVersion++;
+}
+#pragma endregion Scene
+
+//Reverses the calculated order of reflection absorptions
+void ReverseAbsorptionOrder(std::vector<reflectInfo> &reflectedSources) {
+	float totalDampen = 1;
+
+	for (int i = reflectedSources.size() - 1; i >= 0; i--) {
+		totalDampen *= reflectedSources[i].hit.mtl.soundDampenPercent();
+		reflectedSources[i].totalAbsorbed = totalDampen;
+	}
+}
+
+#pragma region Intersection
+// Tests one sphere. On a hit in front of the ray stores its distance in t
+bool HitSphere(const Sphere& sphere, const Ray& ray, float& t) {
+	glm::vec3 oc = ray.getOrig() - sphere.center;
+	float b = glm::dot(ray.getDir(), oc);
+	float dd = glm::dot(ray.getDir(), ray.getDir());
+	float oc2 = glm::dot(oc, oc);
+	float r2 = sphere.radius * sphere.radius;
+
+	// Test for ray-sphere intersection; b^2 - 4ac
+	float discriminant = b * b - dd * (oc2 - r2);
+	if (discriminant < 0.0f)
+		return false;
+
+	// find the t value of closet ray-sphere intersection
+	if (oc2 > r2) //finds hit facing you (use if outside sphere)
+		t = (-b - sqrtf(discriminant)) / dd;
+	else //finds hit facing from you (use if inside sphere)
+		t = (-b + sqrtf(discriminant)) / dd;
+	return t > 0.0f;
+}
+
+// Tests one triangle (Moller-Trumbore). On a hit in front of the ray stores its distance in t
+bool HitTriangle(const Triangle& tri, const Ray& ray, float& t) {
+	//calculate the normal of the triangle
+	glm::vec3 edge1 = tri.v1 - tri.v0;
+	glm::vec3 edge2 = tri.v2 - tri.v0;
+	glm::vec3 h = glm::cross(ray.getDir(), edge2);
+	float a = glm::dot(edge1, h);
+
+	#pragma region CheckIntersection
+	if (a > -1e-7 && a < 1e-7) // This means the ray is parallel to the triangle. No intersection so we skip this triangle
+		return false;
+
+	// Compute the factor to check if the intersection point is inside the triangle
+	float f = 1.0 / a;
+	glm::vec3 s = ray.getOrig() - tri.v0;
+	float u = f * glm::dot(s, h);
+
+	if (u < 0.0 || u > 1.0)
+		return false; // The intersection point is outside the triangle
+
+	glm::vec3 q = glm::cross(s, edge1);
+	float v = f * glm::dot(ray.getDir(), q);
+
+	if (v < 0.0 || u + v > 1.0)
+		return false; // The intersection point is outside the triangle
+	#pragma endregion CheckIntersection
+
+	//We know that there is an intersection with the triangle
+	// So we can compute t to find out where the intersection point is on the line.
+	t = f * glm::dot(edge2, q);
+	return t > 1e-7;
+}
+
+void SetSphereHit(const Scene& scene, int index, const Ray& ray, float t, HitInfo& hit) {
+	const Sphere& sphere = scene.getSpheres()[index];
+	hit.t = t;
+	hit.position = ray.getOrig() + (ray.getDir() * t);
+	hit.normal = normalize((hit.position - sphere.center) / sphere.radius);
+	hit.mtl = scene.getMaterial(sphere.material);
+	hit.primitive = index | BVH_SPHERE_BIT;
+}
+
+void SetTriangleHit(const Scene& scene, int index, const Ray& ray, float t, HitInfo& hit) {
+	hit.t = t;
+	hit.position = ray.getOrig() + ray.getDir() * t;
+	hit.normal = scene.getTriangles().getNormal(index); // Compute normal at the intersection point
+	hit.mtl = scene.getMaterial(scene.getTriangles().material(index));
+	hit.primitive = index;
+}
+
+// Intersects the given ray with all spheres in the scene
+// and updates the given HitInfo using the information of the sphere
+// that first intersects with the ray.
+// Returns true if an intersection is found.
+bool IntersectRaySphere(const Scene& scene, HitInfo& hit, const Ray& ray) {
+	hit.t = 1e30;
+	bool foundHit = false;
+	const std::vector<Sphere>& spheres = scene.getSpheres();
+
+	for (int i = 0; i < spheres.size(); ++i) {
+		float t;
+		// If intersection is found, update the given HitInfo
+		if (HitSphere(spheres[i], ray, t) && t <= hit.t) {
+			foundHit = true;
+			SetSphereHit(scene, i, ray, t, hit);
+		}
+	}
+	return foundHit;
+}
+
+// Intersects the given ray with triangles in the scene
+// and updates the given HitInfo using the information of the triangle
+// that first intersects with the ray.
+// Returns true if an intersection is found.
+bool IntersectRayTriangle(const Scene& scene, HitInfo& hit, const Ray& ray) {
+	hit.t = 1e30;
+	const TriangleStore& triangles = scene.getTriangles();
+	if (triangles.size() == 0)
+		return false;
+
+	//one kernel call streams through the whole store, see RayKernels.h
+	KernelRay kernelRay = { ray.getOrig().x, ray.getOrig().y, ray.getOrig().z, ray.getDir().x, ray.getDir().y, ray.getDir().z, glm::dot(ray.getDir(), ray.getDir()) };
+	float t = hit.t;
+	int closest = rayKernels().triangles(kernelRay, triangles.arrays(), 0, triangles.size(), t);
+	if (closest < 0)
+		return false;
+
+	SetTriangleHit(scene, closest, ray, t, hit);
+	return true;
+}
+
+bool IntersectScene(const Scene& scene, HitInfo& hit, const Ray& ray) {
+	//a few hundred primitives are faster to stream through the kernels than to traverse
+	const BVH* bvh = scene.getBVH();
+	if (bvh != NULL && scene.getTriangles().size() + scene.getSpheres().size() >= BVH_MIN_PRIMITIVES)
+		return bvh->intersect(scene, hit, ray);
+
+	// Check for sphere intersection
+	bool hitFound = IntersectRaySphere(scene, hit, ray);
+
+	// Check for triangle intersection
+	HitInfo triangleHit;
+	if (IntersectRayTriangle(scene, triangleHit, ray) && (!hitFound || triangleHit.t < hit.t)) {
+		hit = triangleHit;
+		hitFound = true;
+	}
+	return hitFound;
+}
+#pragma endregion Intersection
+
+
+//TODO: modify this. It only computes light rendering at a point. But we can hear places we cannot see. We need to return sound sources at all intersection points
+// Given a ray, returns the sound where the ray intersects a sphere.
+// If the ray does not hit a sphere, returns nothing.
+std::vector<reflectInfo> RayTracer(const Scene& scene, Ray ray) {
+	HitInfo hit;
+	std::vector<reflectInfo> reflectedSources; // stores all sound source instances, the returned ones will play one bit of sound
+	int MAX_BOUNCES = 3;
+	bool hitFound = false;
+
+	hitFound = IntersectScene(scene, hit, ray);
+
+	if (hitFound) {
+		glm::vec3 view = normalize(-ray.getDir());
+		reflectInfo newReflectedSound(hit);
+		newReflectedSound.pathLength = hit.t * glm::length(ray.getDir());
+		reflectedSources.push_back(newReflectedSound);
+		if (hit.mtl.isSource) return reflectedSources; // if the hit object is a sound source, stop tracing reflections
+
+		// Compute reflections
+		for (int bounce = 0; bounce < MAX_BOUNCES; ++bounce) {
+
+			Ray r;	// this is the new reflection ray
+			HitInfo h;	// reflection new hit info
+			bool reflectionHitFound = false;
+
+			// Initialize the reflection ray
+			r.setDir(normalize(ray.getDir()) - 2 * dot(normalize(ray.getDir()), hit.normal) * hit.normal);
+			r.setOrig(hit.position + r.getDir() * 0.0001f);
+
+			reflectionHitFound = IntersectScene(scene, h, r);
+
+			if (reflectionHitFound) {
+				// TODO: Hit found, so make a sound at the hit point (not implemented)
+				reflectInfo newReflectedSound(h, reflectedSources.back().totalAbsorbed);
+				newReflectedSound.pathLength = reflectedSources.back().pathLength + h.t * glm::length(r.getDir());
+				reflectedSources.push_back(newReflectedSound);
+
+				ReverseAbsorptionOrder(reflectedSources);
+				if (h.mtl.isSource) return reflectedSources; // if the hit object is a sound source, stop tracing reflections
+
+				// Update the loop variables for tracing the next reflection ray
+				hit = h;
+				ray = r;
+			}
+			else {
+				// TODO: The refleciton ray did not intersect with anything,
+				// so we are using the environment sound (not implemented)
+				//clr += k_s * textureCube(envMap, r.dir.xzy).rgb;
+				break;	// no more reflections
+			}
+		}
+
+		//returns empty source buffer cuz no sound source was hit
+		reflectedSources.clear();
+		return reflectedSources;	// TODO: return the environment sound
+	}
+	else
+		//returns empty source buffer
+		return reflectedSources;	// TODO: return the environment sound
+}
+
+// every thread draws from its own counter stream, so rays can be generated from any worker without locking
+// seeded from the OS: use RayRandom directly where results must be reproducible
+float get_random() {
+	thread_local RayRandom rng(((uint64_t)std::random_device{}() << 32) | std::random_device{}(), 0);
+	return rng.uniform();
+}
+
+Ray GetRandomRay(Listener listener) {
+	//uniform over the sphere; three uniform components would favour the cube's corners
+	float z = get_random();
+	float r = sqrtf(std::max(0.0f, 1 - z * z));
+	float phi = 3.14159265f * get_random();
+	return Ray(listener.pos, glm::vec3(r * cosf(phi), r * sinf(phi), z));
+}
+
+Ray GetRandomRay(Listener listener, RayRandom& rng) {
+	float u = rng.uniform01();
+	return Ray(listener.pos, SquareToSphere(u, rng.uniform01()));
+}
+
+void TraceRayBatch(const Scene& scene, const Listener& listener, int rayCount, std::vector<reflectInfo>& reflections, uint64_t frame, RaySampling sampling) {
+	reflections.clear();
+
+	//one direction set per batch, keyed by the frame so the same frame always traces the same rays
+	std::vector<glm::vec3> dirs;
+	GenerateDirections(sampling, rayCount, frame, dirs);
+
+	//a few ranges per worker balances rays that bounce more than others, merged in order so the result does not depend on scheduling
+	sharedPool().parallelCollect<reflectInfo>(rayCount, 1, reflections, [&](int begin, int end, std::vector<reflectInfo>& out) {
+		for (int i = begin; i < end; i++) {
+			std::vector<reflectInfo> path = RayTracer(scene, Ray(listener.pos, dirs[i]));
+			out.insert(out.end(), path.begin(), path.end());
+		}
+	});
+}
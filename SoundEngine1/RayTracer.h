@@ -0,0 +1,191 @@
+#pragma once
+#ifndef RAYTRACER
+#define RAYTRACER
+#include <vector>
+#include <random>
+
+#include <glm.hpp>
+
+#include "ALUtilities.h"
+#include "TriangleStore.h"
+#include "BVH.h"
+#include "RaySampling.h"
+
+class RayRandom;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////  Ray Tracing Code  //////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class Ray{
+private:
+	glm::vec3 origin;    // M
+	glm::vec3 direction; // n, must be a unit vector
+public:
+	Ray() {};
+	Ray(glm::vec3 orig, glm::vec3 dir) : origin(orig), direction(dir) {}
+	//~Ray() {}
+	const glm::vec3& getOrig() const { return origin; }
+	const glm::vec3& getDir() const { return direction; } // if you don't init get functions like this, accessing this method from const reference objects would be impossible
+	void setOrig(glm::vec3 _origin) { origin = _origin; }
+	void setDir(glm::vec3 _direction) { direction = _direction; }
+
+	// calculates M + nx -- returns vector length between origin and a point
+	glm::vec3 at(float x) const	{ return (origin + (direction * x)); }
+};
+
+// frequency bands materials reflect separately: below 250 Hz, 250 Hz - 1 kHz, 1 - 4 kHz, above 4 kHz (see Echogram.h)
+#define MATERIAL_BANDS 4
+
+struct Material {
+	float	notAbsorbed;		// absorption modifier (ranges from 0.0 to 1.0)
+	float	bandNotAbsorbed[MATERIAL_BANDS];	// the same per frequency band
+	bool	isSource = false;	//is this a sound source?
+	//may also have a scatter modifier (how much randomization to add to reflection) -> not sure if necessary
+
+	Material(float _absorbModifier = 0.4, bool _isSource = false) : notAbsorbed(_absorbModifier), isSource(_isSource) {
+		for (int b = 0; b < MATERIAL_BANDS; b++)
+			bandNotAbsorbed[b] = _absorbModifier;
+	}
+	// broadband modifier is the mean of the bands
+	Material(const float _bands[MATERIAL_BANDS], bool _isSource = false) : notAbsorbed(0), isSource(_isSource) {
+		for (int b = 0; b < MATERIAL_BANDS; b++) {
+			bandNotAbsorbed[b] = _bands[b];
+			notAbsorbed += _bands[b] / MATERIAL_BANDS;
+		}
+	}
+
+	float soundDampenPercent() const { return notAbsorbed; }
+	float soundDampenPercent(int band) const { return bandNotAbsorbed[band]; }
+};
+
+// primitives refer to their material by index into Scene::materials
+// (triangles are in TriangleStore.h)
+struct Sphere {
+	glm::vec3	center;
+	float		radius;
+	int			material = 0;
+
+	Sphere() : center(glm::vec3(0, 0, 0)), radius(2) {}; // default sphere at origin with radius 2
+	Sphere(glm::vec3 _center, float	_radius, int _material = 0) : center(_center), radius(_radius), material(_material) {}; // sphere at given center with given radius
+};
+
+/**
+ * geometry the tracer runs against, built once and passed around by const reference
+ * removing a primitive moves the last one of its kind into the freed index
+ * every change bumps the version, so anything derived from the scene can tell it is stale
+ */
+class Scene {
+private:
+	std::vector<Material> materials;	// materials[0] is the default material
+	std::vector<Sphere> spheres;
+	TriangleStore triangles;
+	unsigned int version = 0;
+	unsigned int triangleVersion = 0;	// bumped only by triangle edits
+	unsigned int sphereVersion = 0;		// bumped by sphere removals and material changes, not by moves
+	BVH bvh;
+	unsigned int bvhVersion = ~0u;	// scene version the BVH was built from
+public:
+	Scene() { materials.push_back(Material()); }
+
+	// returns the index of the new material, or -1 once TRIANGLE_MAX_MATERIALS exist (triangles keep 16 bit material indices)
+	int addMaterial(Material mtl);
+	void setMaterial(int index, Material mtl) { materials[index] = mtl; version++; sphereVersion++; }
+	const Material& getMaterial(int index) const { return materials[index]; }
+
+	// returns the index of the new primitive. A triangle whose material does not exist is rejected with -1
+	int addSphere(const Sphere& sphere);
+	int addTriangle(const Triangle& triangle);
+	// moves or resizes a sphere in place, its index stays valid. Changing its material bumps getSphereVersion()
+	void setSphere(int index, const Sphere& sphere);
+	void removeSphere(int index);
+	void removeTriangle(int index);
+	void clear();
+
+	const std::vector<Sphere>& getSpheres() const { return spheres; }
+	const TriangleStore& getTriangles() const { return triangles; }
+	Triangle getTriangle(int index) const { return triangles.get(index); }
+	unsigned int getVersion() const { return version; }
+	// changes only when triangles are added or removed, so triangle indices are stable while it holds
+	unsigned int getTriangleVersion() const { return triangleVersion; }
+	// changes when a sphere index may refer to another sphere, or a sphere or material may have stopped
+	// (or started) being a source. Moving spheres with setSphere() keeps it
+	unsigned int getSphereVersion() const { return sphereVersion; }
+
+	// (re)builds the BVH over all primitives. Edits made afterwards are only traced once it is rebuilt
+	void buildBVH();
+	// NULL if the BVH was never built or the scene changed since
+	const BVH* getBVH() const { return bvhVersion == version ? &bvh : NULL; }
+};
+
+//struct Light { //for me this is sound
+//	vec3 position;
+//	vec3 intensity;
+//};
+
+struct HitInfo {
+	float		t; //closest hit distance
+	glm::vec3	position;
+	glm::vec3	normal;
+	Material	mtl;
+	unsigned int primitive = 0;	// triangle index, or sphere index | BVH_SPHERE_BIT
+};
+
+// plain record of one reflection on a path; has no OpenAL state, see Echogram::addPaths() and EchogramStream::render() for playback
+struct reflectInfo {
+	HitInfo hit;
+	float totalAbsorbed; // multiply with original sound source to get dampened sound (reduced amplitude)
+	float pathLength = 0; // distance travelled from the listener up to this hit
+
+	reflectInfo(HitInfo _hit) : hit(_hit) { totalAbsorbed = hit.mtl.soundDampenPercent(); }
+	reflectInfo(HitInfo _hit, float prevDampen) : hit(_hit) { totalAbsorbed = prevDampen * _hit.mtl.soundDampenPercent(); }
+};
+
+//int MAX_BOUNCES = 3;
+//uniform Light  lights[NUM_LIGHTS]; //number of sound sources
+//uniform samplerCube envMap; //pretty sure this is just a cube map
+//int bounceLimit = 3; //don't understand why this is needed?
+
+//Reverses the calculated order of reflection absorptions
+void ReverseAbsorptionOrder(std::vector<reflectInfo>& reflectedSources);
+
+// Intersects the given ray with all spheres in the scene
+// and updates the given HitInfo using the information of the sphere
+// that first intersects with the ray.
+// Returns true if an intersection is found.
+bool IntersectRaySphere(const Scene& scene, HitInfo& hit, const Ray& ray);
+
+// Same for the triangles of the scene
+bool IntersectRayTriangle(const Scene& scene, HitInfo& hit, const Ray& ray);
+
+// Closest hit over every primitive, through the BVH if it is up to date
+bool IntersectScene(const Scene& scene, HitInfo& hit, const Ray& ray);
+
+// single primitive tests, t is only written on a hit in front of the ray
+bool HitSphere(const Sphere& sphere, const Ray& ray, float& t);
+bool HitTriangle(const Triangle& tri, const Ray& ray, float& t);
+// fill in the hit record once the closest primitive is known
+void SetSphereHit(const Scene& scene, int index, const Ray& ray, float t, HitInfo& hit);
+void SetTriangleHit(const Scene& scene, int index, const Ray& ray, float t, HitInfo& hit);
+
+
+//TODO: modify this. It only computes light rendering at a point. But we can hear places we cannot see. We need to return sound sources at all intersection points
+// Given a ray, returns the sound where the ray intersects a sphere.
+// If the ray does not hit a sphere, returns nothing.
+std::vector<reflectInfo> RayTracer(const Scene& scene, Ray ray);
+
+// uniform in [-1, 1), safe to call from any thread but not reproducible
+float get_random();
+
+// unit direction, uniform over the sphere
+Ray GetRandomRay(Listener listener);
+// same, drawn from a counter-based stream (see CounterRNG.h)
+Ray GetRandomRay(Listener listener, RayRandom& rng);
+
+// traces rayCount rays from the listener on the shared thread pool (see ThreadPool.h)
+// and collects every reflection, replacing the contents of reflections
+// directions come from one randomly rotated set of the given scheme (see RaySampling.h), keyed by frame:
+// the same scene, listener and frame give bit identical reflections on any number of threads
+// the scene must not be edited while this runs
+void TraceRayBatch(const Scene& scene, const Listener& listener, int rayCount, std::vector<reflectInfo>& reflections, uint64_t frame, RaySampling sampling = SAMPLING_FIBONACCI);
+#endif
@@ -0,0 +1,115 @@
+#include "TemporalPaths.h"
+#include "ImageSource.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+void PathCache::clear() {
+	paths.clear();
+	known.clear();
+}
+
+// true if path hits exactly the cached primitives and then the cached source
+static bool followsPath(const std::vector<reflectInfo>& path, const CachedPath& cached) {
+	if (path.size() != cached.primitives.size() + 1 || path.back().hit.primitive != (cached.source | BVH_SPHERE_BIT))
+		return false;
+	for (int i = 0; i < cached.primitives.size(); i++) {
+		if (path[i].hit.primitive != cached.primitives[i])
+			return false;
+	}
+	return true;
+}
+
+bool PathCache::revalidate(const Scene& scene, const Listener& listener, CachedPath& cached, std::vector<reflectInfo>& path) const {
+	path.clear();
+	if (cached.source >= scene.getSpheres().size())
+		return false;
+
+	if (cached.specular) {
+		std::vector<int> triangles(cached.primitives.begin(), cached.primitives.end());
+		if (SolveSpecularPath(scene, listener.pos, triangles, cached.source, path)) {
+			cached.direction = glm::normalize(path[0].hit.position - listener.pos);
+			return true;
+		}
+	}
+
+	//a sphere on the way has no mirror image, and a path that grazes the source's edge has no exact solution
+	//towards its center, so follow the same ray again and see if it still gets there
+	path = RayTracer(scene, Ray(listener.pos, cached.direction));
+	return followsPath(path, cached);
+}
+
+bool PathCache::remember(const Listener& listener, const reflectInfo* path, int length) {
+	CachedPath cached;
+	cached.source = path[length - 1].hit.primitive & ~BVH_SPHERE_BIT;
+	cached.direction = glm::normalize(path[0].hit.position - listener.pos);
+	cached.specular = true;
+	for (int i = 0; i < length - 1; i++) {
+		cached.primitives.push_back(path[i].hit.primitive);
+		if (path[i].hit.primitive & BVH_SPHERE_BIT)
+			cached.specular = false;
+	}
+
+	std::vector<unsigned int> key = cached.primitives;
+	key.push_back(path[length - 1].hit.primitive);
+	if (known.count(key) > 0)
+		return false;
+	if (paths.size() < PATH_CACHE_MAX) {
+		known.insert(key);
+		paths.push_back(cached);
+	}
+	return true;
+}
+
+void PathCache::trace(const Scene& scene, const Listener& listener, int rayCount, std::vector<reflectInfo>& reflections, uint64_t frame, RaySampling sampling) {
+	reflections.clear();
+	if (triangleVersion != scene.getTriangleVersion() || sphereVersion != scene.getSphereVersion()) {
+		clear();	//primitive indices moved, or a source may not be one any more
+		triangleVersion = scene.getTriangleVersion();
+		sphereVersion = scene.getSphereVersion();
+	}
+
+	//check every cached path on the pool
+	int count = (int)paths.size();
+	std::vector<char> valid(count);
+	sharedPool().parallelCollect<reflectInfo>(count, 16, reflections, [&](int begin, int end, std::vector<reflectInfo>& out) {
+		std::vector<reflectInfo> path;
+		for (int i = begin; i < end; i++) {
+			valid[i] = revalidate(scene, listener, paths[i], path);
+			if (valid[i])
+				out.insert(out.end(), path.begin(), path.end());
+		}
+	});
+
+	//drop the paths that broke, they are found again by the new rays if they come back
+	int kept = 0;
+	for (int i = 0; i < count; i++) {
+		if (valid[i])
+			paths[kept++] = paths[i];
+		else {
+			std::vector<unsigned int> key = paths[i].primitives;
+			key.push_back(paths[i].source | BVH_SPHERE_BIT);
+			known.erase(key);
+		}
+	}
+	paths.resize(kept);
+	lastReused = kept;
+
+	//spend the rest of the budget on paths the cache does not have yet
+	int discoveryRays = paths.empty() ? rayCount : std::max(1, (int)(rayCount * discoveryFraction));
+	std::vector<reflectInfo> fresh;
+	TraceRayBatch(scene, listener, discoveryRays, fresh, frame, sampling);
+
+	lastDiscovered = 0;
+	int begin = 0;
+	for (int i = 0; i < fresh.size(); i++) {
+		if (!fresh[i].hit.mtl.isSource)
+			continue;
+		//every path ends on a source
+		if (remember(listener, &fresh[begin], i + 1 - begin)) {
+			reflections.insert(reflections.end(), fresh.begin() + begin, fresh.begin() + i + 1);
+			lastDiscovered++;
+		}
+		begin = i + 1;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef TEMPORALPATHS
+#define TEMPORALPATHS
+#include <vector>
+#include <set>
+
+#include <glm.hpp>
+
+#include "RayTracer.h"
+
+// share of the ray budget spent on finding new paths while the cache is warm
+#define PATH_DISCOVERY_FRACTION 0.1f
+// most paths kept between passes
+#define PATH_CACHE_MAX 4096
+
+// a source-reaching path remembered by what it hit rather than by where
+struct CachedPath {
+	std::vector<unsigned int> primitives;	// reflectors in the order the sound meets them, see HitInfo::primitive
+	int source;								// index into Scene::getSpheres()
+	glm::vec3 direction;					// first leg of the last pass it was valid in, retraced when it cannot be solved
+	bool specular;							// only triangles: solved exactly where possible, see SolveSpecularPath()
+};
+
+/**
+ * keeps the source-reaching paths of the previous passes and checks them again instead of searching anew
+ * paths that only reflect on triangles are solved exactly for the new listener and source positions;
+ * the others retrace the last ray that followed them. A share of the rays still looks for new paths
+ * the cache survives moving listeners and sources, and is dropped when triangles are added or removed,
+ * spheres are removed or materials change
+ */
+class PathCache {
+private:
+	std::vector<CachedPath> paths;
+	std::set<std::vector<unsigned int>> known;	// primitives + source of every cached path
+	unsigned int triangleVersion = ~0u;
+	unsigned int sphereVersion = ~0u;
+	float discoveryFraction;
+	int lastReused = 0, lastDiscovered = 0;
+
+	// re-checks one cached path, false if it no longer reaches its source
+	bool revalidate(const Scene& scene, const Listener& listener, CachedPath& cached, std::vector<reflectInfo>& path) const;
+	// caches a path found by a ray unless the cache is full, false if it is already cached
+	bool remember(const Listener& listener, const reflectInfo* path, int length);
+public:
+	PathCache(float _discoveryFraction = PATH_DISCOVERY_FRACTION) : discoveryFraction(_discoveryFraction) {}
+
+	void clear();
+	/**
+	 * same as TraceRayBatch(), except that rays which would only find a cached path again are saved:
+	 * every cached path is re-checked first, then rayCount * discoveryFraction rays look for new ones
+	 * (all rayCount while the cache is empty). Replaces the contents of reflections
+	 */
+	void trace(const Scene& scene, const Listener& listener, int rayCount, std::vector<reflectInfo>& reflections, uint64_t frame, RaySampling sampling = SAMPLING_FIBONACCI);
+
+	int size() const { return (int)paths.size(); }
+	// paths that were still valid, and new paths found, in the last pass
+	int reusedCount() const { return lastReused; }
+	int discoveredCount() const { return lastDiscovered; }
+};
+#endif
@@ -0,0 +1,76 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0) // hardware_concurrency may not know
+		threadCount = 4;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	taskReady.notify_all();
+	for (int i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void ThreadPool::workerLoop() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			taskReady.wait(guard, [this] { return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty())
+				return;
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+
+		task();
+
+		std::lock_guard<std::mutex> guard(lock);
+		if (--pending == 0)
+			allDone.notify_all();
+	}
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		tasks.push(std::move(task));
+		pending++;
+	}
+	taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> guard(lock);
+	allDone.wait(guard, [this] { return pending == 0; });
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task) {
+	//a few contiguous ranges per worker keeps the queue short while still balancing uneven tasks
+	int chunks = std::min(count, size() * 4);
+	for (int c = 0; c < chunks; c++) {
+		int begin = (int)((long long)count * c / chunks);
+		int end = (int)((long long)count * (c + 1) / chunks);
+		enqueue([&task, begin, end] {
+			for (int i = begin; i < end; i++)
+				task(i);
+		});
+	}
+	wait();
+}
+
+ThreadPool& sharedPool() {
+	static ThreadPool pool;
+	return pool;
+}
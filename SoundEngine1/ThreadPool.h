@@ -0,0 +1,67 @@
+#pragma once
+#ifndef THREADPOOL
+#define THREADPOOL
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+/**
+ * fixed set of worker threads pulling tasks from a shared queue
+ * tasks must not touch OpenAL state that belongs to the context thread
+ */
+class ThreadPool {
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::mutex lock;
+	std::condition_variable taskReady;	// signalled when a task is queued or the pool shuts down
+	std::condition_variable allDone;	// signalled when the last pending task finishes
+	int pending = 0;					// queued + running tasks
+	bool stopping = false;
+
+	void workerLoop();
+public:
+	// threadCount of 0 uses one thread per hardware core
+	ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int size() const { return (int)workers.size(); }
+
+	void enqueue(std::function<void()> task);
+	// blocks until every queued task has finished
+	void wait();
+	// runs task(i) for i in [0, count) spread over the pool and waits for all of them
+	// must not be called from inside a pool task
+	void parallelFor(int count, const std::function<void(int)>& task);
+
+	/**
+	 * runs task(begin, end, out) over contiguous ranges of [0, count), a few per worker and at least
+	 * minChunk items each, and appends every range's out to result in range order, so result does not
+	 * depend on scheduling. Small counts run on the calling thread. Same restriction as parallelFor
+	 */
+	template<typename T>
+	void parallelCollect(int count, int minChunk, std::vector<T>& result, const std::function<void(int, int, std::vector<T>&)>& task) {
+		int chunks = std::max(1, std::min(count / std::max(minChunk, 1), size() * 4));
+		if (chunks == 1) {
+			task(0, count, result);
+			return;
+		}
+
+		std::vector<std::vector<T>> buffers(chunks);
+		parallelFor(chunks, [&](int c) {
+			task((int)((long long)count * c / chunks), (int)((long long)count * (c + 1) / chunks), buffers[c]);
+		});
+		for (int c = 0; c < chunks; c++)
+			result.insert(result.end(), buffers[c].begin(), buffers[c].end());
+	}
+};
+
+// process-wide pool shared by the loaders
+ThreadPool& sharedPool();
+#endif
@@ -0,0 +1,121 @@
+#include "TriangleStore.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+static float* alignedFloats(size_t count) {
+#ifdef _WIN32
+	void* p = _aligned_malloc(count * sizeof(float), TRIANGLE_STORE_ALIGN);
+#else
+	void* p = aligned_alloc(TRIANGLE_STORE_ALIGN, count * sizeof(float));
+#endif
+	if (p == NULL)
+		throw std::bad_alloc();
+	return (float*)p;
+}
+
+static void freeAligned(float* p) {
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+TriangleStore::~TriangleStore() {
+	freeAligned(data);
+	delete[] materials;
+}
+
+TriangleStore::TriangleStore(const TriangleStore& other) {
+	reserveFor(other.count);
+	*this = other;
+}
+
+TriangleStore& TriangleStore::operator=(const TriangleStore& other) {
+	if (this == &other)
+		return *this;
+	clear();
+	reserveFor(other.count);
+	for (int i = 0; i < other.count; i++)
+		add(other, i);
+	return *this;
+}
+
+//grows every array to hold the given number of triangles plus padding, keeping the contents
+void TriangleStore::reserveFor(int triangles) {
+	if (data != NULL && triangles + RAY_KERNEL_PAD <= capacity)
+		return;
+
+	//capacity stays a multiple of 8 floats, so every array keeps the 32 byte alignment of the first
+	int newCapacity = capacity > 0 ? capacity : 64;
+	while (newCapacity < triangles + RAY_KERNEL_PAD)
+		newCapacity *= 2;
+
+	float* newData = alignedFloats((size_t)newCapacity * 9);
+	memset(newData, 0, (size_t)newCapacity * 9 * sizeof(float));
+	uint16_t* newMaterials = new uint16_t[newCapacity]();
+	if (data != NULL) {
+		for (int k = 0; k < 9; k++)
+			memcpy(newData + (size_t)k * newCapacity, data + (size_t)k * capacity, count * sizeof(float));
+		memcpy(newMaterials, materials, count * sizeof(uint16_t));
+	}
+	freeAligned(data);
+	delete[] materials;
+	data = newData;
+	materials = newMaterials;
+	capacity = newCapacity;
+
+	for (int k = 0; k < 3; k++) {
+		soa.v0[k] = data + (size_t)k * capacity;
+		soa.e1[k] = data + (size_t)(3 + k) * capacity;
+		soa.e2[k] = data + (size_t)(6 + k) * capacity;
+	}
+}
+
+int TriangleStore::add(const Triangle& tri) {
+	reserveFor(count + 1);
+	count++;
+	set(count - 1, tri);
+	return count - 1;
+}
+
+int TriangleStore::add(const TriangleStore& from, int index) {
+	reserveFor(count + 1);
+	for (int k = 0; k < 9; k++)
+		data[(size_t)k * capacity + count] = from.data[(size_t)k * from.capacity + index];
+	materials[count] = from.materials[index];
+	return count++;
+}
+
+void TriangleStore::set(int index, const Triangle& tri) {
+	glm::vec3 e1 = tri.v1 - tri.v0;
+	glm::vec3 e2 = tri.v2 - tri.v0;
+	for (int k = 0; k < 3; k++) {
+		data[(size_t)k * capacity + index] = tri.v0[k];
+		data[(size_t)(3 + k) * capacity + index] = e1[k];
+		data[(size_t)(6 + k) * capacity + index] = e2[k];
+	}
+	materials[index] = (uint16_t)tri.material; // Scene::addTriangle rejects materials that do not fit
+}
+
+void TriangleStore::remove(int index) {
+	count--;
+	for (int k = 0; k < 9; k++) {
+		data[(size_t)k * capacity + index] = data[(size_t)k * capacity + count];
+		data[(size_t)k * capacity + count] = 0; // the padding has to stay degenerate
+	}
+	materials[index] = materials[count];
+}
+
+void TriangleStore::clear() {
+	for (int k = 0; k < 9; k++)
+		memset(data + (size_t)k * capacity, 0, count * sizeof(float));
+	count = 0;
+}
+
+Triangle TriangleStore::get(int index) const {
+	glm::vec3 v0 = vertex0(index);
+	return Triangle(v0, v0 + edge1(index), v0 + edge2(index), materials[index]);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef TRIANGLESTORE
+#define TRIANGLESTORE
+#include <stdint.h>
+
+#include <glm.hpp>
+
+#include "RayKernels.h"
+
+// every coordinate array starts on a 32 byte boundary, one aligned AVX2 load
+#define TRIANGLE_STORE_ALIGN 32
+// triangles store their material index in 16 bits
+#define TRIANGLE_MAX_MATERIALS 65536
+
+struct Triangle {
+	glm::vec3 v0, v1, v2;
+	int material = 0;
+
+	Triangle() : v0(glm::vec3(1, 0, 0)), v1(glm::vec3(0, 0, 0)), v2(glm::vec3(0, 0, 1)) {}; // default triangle
+	Triangle(glm::vec3 _v0, glm::vec3 _v1, glm::vec3 _v2, int _material = 0) : v0(_v0), v1(_v1), v2(_v2), material(_material) {}; // triangle with given vertices
+
+	//TODO: Maybe also have a second check for double sided triangles
+	// ie. getNormal() returns the normal of the triangle, but if the ray hits the back side, it should return the negative of the normal
+	glm::vec3 getNormal() const {
+		glm::vec3 edge1 = v1 - v0;
+		glm::vec3 edge2 = v2 - v0;
+		return glm::normalize(glm::cross(edge1, edge2));
+	}
+};
+
+/**
+ * triangles as aligned structure-of-arrays: v0, edge1 = v1 - v0 and edge2 = v2 - v0,
+ * nine float arrays plus a 16 bit material index per triangle (38 bytes instead of 40)
+ * the edges are what the intersection test needs, so nothing is recomputed per ray,
+ * and a kernel streams 8 triangles per cache line of each array
+ * the arrays are always padded by RAY_KERNEL_PAD zeroed (degenerate, never hit) triangles
+ */
+class TriangleStore {
+private:
+	float* data = NULL;			// the nine arrays back to back, capacity floats each
+	uint16_t* materials = NULL;
+	int count = 0;
+	int capacity = 0;			// per array, includes the padding
+	TriangleSoA soa;			// pointers into data
+
+	void reserveFor(int triangles);
+public:
+	TriangleStore() { reserveFor(0); }
+	~TriangleStore();
+	TriangleStore(const TriangleStore& other);
+	TriangleStore& operator=(const TriangleStore& other);
+
+	int size() const { return count; }
+	// returns the index of the new triangle
+	int add(const Triangle& tri);
+	// copies a triangle as stored, without rebuilding its edges
+	int add(const TriangleStore& from, int index);
+	void set(int index, const Triangle& tri);
+	// moves the last triangle into the freed index
+	void remove(int index);
+	void clear();
+
+	Triangle get(int index) const;
+	glm::vec3 vertex0(int index) const { return glm::vec3(soa.v0[0][index], soa.v0[1][index], soa.v0[2][index]); }
+	glm::vec3 edge1(int index) const { return glm::vec3(soa.e1[0][index], soa.e1[1][index], soa.e1[2][index]); }
+	glm::vec3 edge2(int index) const { return glm::vec3(soa.e2[0][index], soa.e2[1][index], soa.e2[2][index]); }
+	glm::vec3 getNormal(int index) const { return glm::normalize(glm::cross(edge1(index), edge2(index))); }
+	int material(int index) const { return materials[index]; }
+
+	// the arrays as the ray kernels take them
+	const TriangleSoA& arrays() const { return soa; }
+};
+#endif
@@ -0,0 +1,213 @@
+#include "VoiceManager.h"
+#include "ALFrame.h"
+
+#include <algorithm>
+
+//handles pack the slot index in the low 20 bits and the slot generation above it
+#define VOICE_INDEX_BITS 20
+#define VOICE_INDEX_MASK ((1 << VOICE_INDEX_BITS) - 1)
+#define VOICE_GENERATION_MASK 0x7FF
+
+VoiceManager::VoiceManager(int _maxReal, float _cutoff) : maxReal(_maxReal), cutoff(_cutoff) {}
+
+VoiceManager::~VoiceManager() {
+	stopAll();
+}
+
+Voice* VoiceManager::get(int handle) {
+	int slot = (handle & VOICE_INDEX_MASK) - 1;
+	unsigned int generation = (unsigned int)handle >> VOICE_INDEX_BITS;
+	if (slot < 0 || slot >= voices.size())
+		return NULL;
+
+	Voice& v = voices[slot];
+	if (!v.active || (v.generation & VOICE_GENERATION_MASK) != generation)
+		return NULL;
+	return &v;
+}
+
+int VoiceManager::play(unsigned int bufferid, glm::vec3 pos, float gain, bool looping) {
+	int slot;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slot = (int)voices.size();
+		voices.push_back(Voice());
+	}
+
+	Voice& v = voices[slot];
+	unsigned int generation = v.generation + 1;
+	v = Voice();
+	v.generation = generation;
+	v.bufferid = bufferid;
+	v.pos = pos;
+	v.gain = gain;
+	v.looping = looping;
+	v.active = true;
+	v.fresh = true;
+
+	//the cursor of a virtual voice needs to know when the buffer runs out
+	int size = 0, channels = 1, bits = 16, frequency = 1;
+	alGetBufferi(bufferid, AL_SIZE, &size);
+	alGetBufferi(bufferid, AL_CHANNELS, &channels);
+	alGetBufferi(bufferid, AL_BITS, &bits);
+	alGetBufferi(bufferid, AL_FREQUENCY, &frequency);
+	if (channels > 0 && bits > 0 && frequency > 0)
+		v.length = float(size) / (channels * (bits / 8)) / frequency;
+
+	return ((int)(generation & VOICE_GENERATION_MASK) << VOICE_INDEX_BITS) | (slot + 1);
+}
+
+void VoiceManager::finish(int slot) {
+	Voice& v = voices[slot];
+	if (v.sourceid != 0) {
+		sourceToSlot.erase(v.sourceid);
+		sourcePool().release(v.sourceid);
+	}
+	v.sourceid = 0;
+	v.active = false;
+	freeSlots.push_back(slot);
+}
+
+void VoiceManager::stop(int handle) {
+	if (get(handle) != NULL)
+		finish((handle & VOICE_INDEX_MASK) - 1);
+}
+
+void VoiceManager::stopAll() {
+	for (int i = 0; i < voices.size(); i++)
+		if (voices[i].active)
+			finish(i);
+}
+
+bool VoiceManager::isPlaying(int handle) {
+	return get(handle) != NULL;
+}
+
+bool VoiceManager::sourceStopped(unsigned int sourceid) {
+	std::unordered_map<unsigned int, int>::iterator it = sourceToSlot.find(sourceid);
+	if (it == sourceToSlot.end())
+		return false;
+
+	//the event may be about a stop we caused ourselves before the source was handed to this voice
+	int state;
+	alGetSourcei(sourceid, AL_SOURCE_STATE, &state);
+	if (state != AL_STOPPED)
+		return false;
+
+	finish(it->second);
+	return true;
+}
+
+void VoiceManager::setPosition(int handle, glm::vec3 pos) {
+	Voice* v = get(handle);
+	if (v == NULL)
+		return;
+	v->pos = pos;
+	if (v->sourceid != 0)
+		setSourcePosition(v->sourceid, pos);
+}
+
+void VoiceManager::setGain(int handle, float gain) {
+	Voice* v = get(handle);
+	if (v == NULL)
+		return;
+	v->gain = gain;
+	if (v->sourceid != 0)
+		setSourceGain(v->sourceid, gain);
+}
+
+//binds a source to the voice and starts it at the voice's cursor
+void VoiceManager::promote(Voice& v) {
+	v.sourceid = sourcePool().acquire();
+	if (v.sourceid == 0)
+		return; // no sources left, stays virtual
+	sourceToSlot[v.sourceid] = (int)(&v - voices.data());
+
+	alSourcei(v.sourceid, AL_BUFFER, v.bufferid);
+	setSourceLooping(v.sourceid, v.looping);
+	setSourceGain(v.sourceid, v.gain);
+	setSourcePosition(v.sourceid, v.pos);
+	alSourcef(v.sourceid, AL_SEC_OFFSET, v.cursor);
+	alSourcePlay(v.sourceid);
+	stats.promotions++;
+}
+
+//takes the source away but remembers where playback was
+void VoiceManager::demote(Voice& v) {
+	alGetSourcef(v.sourceid, AL_SEC_OFFSET, &v.cursor);
+	sourceToSlot.erase(v.sourceid);
+	sourcePool().release(v.sourceid);
+	v.sourceid = 0;
+	stats.demotions++;
+}
+
+void VoiceManager::update(const Listener& listener, float dt) {
+	stats.promotions = 0;
+	stats.demotions = 0;
+	ranking.clear();
+
+	for (int i = 0; i < voices.size(); i++) {
+		Voice& v = voices[i];
+		if (!v.active)
+			continue;
+
+		//advance the cursor: real voices report it, virtual ones are extrapolated
+		if (v.sourceid != 0) {
+			if (!eventDriven) {
+				int state;
+				alGetSourcei(v.sourceid, AL_SOURCE_STATE, &state);
+				if (state == AL_STOPPED) {
+					finish(i);
+					continue;
+				}
+			}
+			//the offset is only needed again if the voice gets demoted, demote() reads it then
+		}
+		else {
+			if (!v.fresh)
+				v.cursor += dt;
+			if (v.cursor >= v.length) {
+				if (!v.looping || v.length <= 0) {
+					finish(i);
+					continue;
+				}
+				v.cursor = fmod(v.cursor, v.length);
+			}
+		}
+
+		v.fresh = false;
+
+		//inverse distance clamped at the reference distance, matching AL's default model
+		float distance = glm::distance(v.pos, listener.pos);
+		v.audibility = v.gain / std::max(distance, 1.0f);
+		ranking.push_back(i);
+	}
+
+	//the maxReal loudest voices above the cutoff get sources
+	int realCount = std::min((int)ranking.size(), maxReal);
+	std::nth_element(ranking.begin(), ranking.begin() + realCount, ranking.end(),
+		[this](int a, int b) { return voices[a].audibility > voices[b].audibility; });
+
+	//demote first so the promoted voices can reuse the freed sources
+	for (int r = realCount; r < ranking.size(); r++)
+		if (voices[ranking[r]].sourceid != 0)
+			demote(voices[ranking[r]]);
+	for (int r = 0; r < realCount; r++) {
+		Voice& v = voices[ranking[r]];
+		if (v.audibility < cutoff) {
+			if (v.sourceid != 0)
+				demote(v);
+		}
+		else if (v.sourceid == 0)
+			promote(v);
+	}
+
+	stats.real = 0;
+	for (int r = 0; r < ranking.size(); r++)
+		if (voices[ranking[r]].sourceid != 0)
+			stats.real++;
+	stats.virtualized = (int)ranking.size() - stats.real;
+}
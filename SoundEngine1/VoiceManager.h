@@ -0,0 +1,83 @@
+#pragma once
+#ifndef VOICEMANAGER
+#define VOICEMANAGER
+#include <vector>
+#include <unordered_map>
+
+#include <AL/al.h>
+
+#include <glm.hpp>
+
+#include "ALUtilities.h"
+#include "RayTracer.h"
+
+struct VoiceStats {
+	int real = 0;		// voices currently backed by an AL source
+	int virtualized = 0;// playing voices without a source (tracked, but silent)
+	int promotions = 0;	// virtual -> real this frame
+	int demotions = 0;	// real -> virtual this frame
+};
+
+/**
+ * a sound instance that may or may not currently own an AL source
+ * the playback cursor keeps advancing while virtual so it resumes at the right spot
+ */
+struct Voice {
+	unsigned int bufferid = 0;
+	glm::vec3 pos = glm::vec3(0, 0, 0);
+	float gain = 1;
+	bool looping = false;
+
+	float cursor = 0;		// playback position in seconds
+	float length = 0;		// buffer length in seconds
+	float audibility = 0;	// gain after distance attenuation, recomputed every update
+	bool active = false;	// slot in use
+	bool fresh = false;		// started since the last update, the cursor has not moved yet
+	unsigned int sourceid = 0;	// 0 while virtual
+	unsigned int generation = 0;// bumped on reuse so stale handles are rejected
+};
+
+/**
+ * tracks any number of voices and maps only the most audible ones onto real AL sources
+ * real sources are taken from and returned to the global source pool (ALPool.h)
+ */
+class VoiceManager {
+private:
+	std::vector<Voice> voices;
+	std::vector<int> freeSlots;
+	std::vector<int> ranking;	// scratch space for update()
+	std::unordered_map<unsigned int, int> sourceToSlot;	// real voices by their source
+	bool eventDriven = false;	// stops arrive through sourceStopped() instead of being polled
+	int maxReal;
+	float cutoff;				// voices quieter than this never get a source
+	VoiceStats stats;
+
+	Voice* get(int handle);
+	void promote(Voice& v);
+	void demote(Voice& v);
+	void finish(int slot);
+public:
+	VoiceManager(int _maxReal = 64, float _cutoff = 0.001f);
+	~VoiceManager();
+
+	// starts a voice and returns its handle (never 0)
+	int play(unsigned int bufferid, glm::vec3 pos, float gain, bool looping = false);
+	void stop(int handle);
+	void stopAll();
+	bool isPlaying(int handle);
+	void setPosition(int handle, glm::vec3 pos);
+	void setGain(int handle, float gain);
+
+	// advances virtual voices by dt seconds and re-decides which voices are real
+	void update(const Listener& listener, float dt);
+
+	// with AL_SOFT_events (ALEvents.h) real voices are not polled every update;
+	// the main loop reports stopped sources instead
+	void setEventDriven(bool enabled) { eventDriven = enabled; }
+	// finishes the voice playing on this source. Returns false if no voice owns it
+	bool sourceStopped(unsigned int sourceid);
+
+	const VoiceStats& getStats() const { return stats; }
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "Wavetable.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#define WAVETABLE_FRAC_BITS (32 - WAVETABLE_BITS)
+#define WAVETABLE_FRAC_SCALE (1.0f / (1 << WAVETABLE_FRAC_BITS))
+
+static const double PI = 3.14159265358979323846;
+
+//amplitude of harmonic h in the Fourier series of each waveform (sine phase)
+static double harmonicAmplitude(Waveform wave, int h) {
+	switch (wave) {
+	case WAVE_SINE:
+		return h == 1 ? 1.0 : 0.0;
+	case WAVE_TRIANGLE:
+		if (h % 2 == 0) return 0.0;
+		return ((h / 2) % 2 == 0 ? 1.0 : -1.0) * 8.0 / (PI * PI * h * h);
+	case WAVE_SQUARE:
+		return h % 2 == 0 ? 0.0 : 4.0 / (PI * h);
+	case WAVE_SAW:
+		return (h % 2 == 0 ? -2.0 : 2.0) / (PI * h);
+	}
+	return 0.0;
+}
+
+WavetableSet::WavetableSet(Waveform wave) {
+	//sin(2*pi*k/N) for every k, so harmonic h at sample i is sinTable[(h * i) % N]
+	std::vector<double> sinTable(WAVETABLE_SIZE);
+	for (int i = 0; i < WAVETABLE_SIZE; i++)
+		sinTable[i] = sin(2 * PI * i / WAVETABLE_SIZE);
+
+	std::vector<double> sum(WAVETABLE_SIZE);
+	for (int level = 0; level < WAVETABLE_LEVELS; level++) {
+		int maxHarmonic = (WAVETABLE_SIZE / 2) >> level;
+		std::fill(sum.begin(), sum.end(), 0.0);
+
+		for (int h = 1; h <= maxHarmonic; h++) {
+			double a = harmonicAmplitude(wave, h);
+			if (a == 0.0)
+				continue;
+			//Lanczos sigma factor tames the Gibbs ringing at the discontinuities of square and saw
+			double x = PI * h / (maxHarmonic + 1);
+			a *= sin(x) / x;
+			for (int i = 0; i < WAVETABLE_SIZE; i++)
+				sum[i] += a * sinTable[(h * i) & (WAVETABLE_SIZE - 1)];
+		}
+
+		double peak = 0;
+		for (int i = 0; i < WAVETABLE_SIZE; i++)
+			peak = std::max(peak, fabs(sum[i]));
+		if (peak == 0)
+			peak = 1;
+
+		levels[level].resize(WAVETABLE_SIZE + 1);
+		for (int i = 0; i < WAVETABLE_SIZE; i++)
+			levels[level][i] = (float)(sum[i] / peak);
+		levels[level][WAVETABLE_SIZE] = levels[level][0];
+	}
+}
+
+const float* WavetableSet::levelFor(float freq, unsigned int sampleRate) const {
+	//harmonics that fit below Nyquist at this frequency
+	float allowed = (sampleRate * 0.5f) / std::max(freq, 1.0f);
+	int level = 0;
+	while (level < WAVETABLE_LEVELS - 1 && ((WAVETABLE_SIZE / 2) >> level) > allowed)
+		level++;
+	return levels[level].data();
+}
+
+const WavetableSet& wavetable(Waveform wave) {
+	static const WavetableSet sine(WAVE_SINE);
+	static const WavetableSet triangle(WAVE_TRIANGLE);
+	static const WavetableSet square(WAVE_SQUARE);
+	static const WavetableSet saw(WAVE_SAW);
+
+	switch (wave) {
+	case WAVE_TRIANGLE: return triangle;
+	case WAVE_SQUARE: return square;
+	case WAVE_SAW: return saw;
+	default: return sine;
+	}
+}
+
+static unsigned int phaseIncrement(float freq, unsigned int sampleRate) {
+	return (unsigned int)(long long)llround((double)freq / sampleRate * 4294967296.0);
+}
+
+//linear interpolation between two neighbouring table entries
+static inline float lookup(const float* table, unsigned int phase) {
+	unsigned int index = phase >> WAVETABLE_FRAC_BITS;
+	float frac = (phase & ((1u << WAVETABLE_FRAC_BITS) - 1)) * WAVETABLE_FRAC_SCALE;
+	float a = table[index];
+	return a + (table[index + 1] - a) * frac;
+}
+
+WavetableOscillator::WavetableOscillator(Waveform wave, float freq, unsigned int _sampleRate, float _amplitude)
+	: tables(&wavetable(wave)), sampleRate(_sampleRate), amplitude(_amplitude)
+{
+	setFrequency(freq);
+}
+
+void WavetableOscillator::setFrequency(float freq) {
+	increment = phaseIncrement(freq, sampleRate);
+	table = tables->levelFor(freq, sampleRate);
+}
+
+void WavetableOscillator::fill(float* out, int count) {
+	unsigned int p = phase;
+	for (int i = 0; i < count; i++) {
+		out[i] = lookup(table, p) * amplitude;
+		p += increment; // wraps around at the end of the period by itself
+	}
+	phase = p;
+}
+
+int OscillatorBank::add(Waveform wave, float freq, float gain) {
+	const WavetableSet* set = &wavetable(wave);
+	tables.push_back(set);
+	levels.push_back(set->levelFor(freq, sampleRate));
+	phases.push_back(0);
+	increments.push_back(phaseIncrement(freq, sampleRate));
+	gains.push_back(gain);
+	return (int)phases.size() - 1;
+}
+
+void OscillatorBank::remove(int index) {
+	int last = (int)phases.size() - 1;
+	tables[index] = tables[last];
+	levels[index] = levels[last];
+	phases[index] = phases[last];
+	increments[index] = increments[last];
+	gains[index] = gains[last];
+
+	tables.pop_back();
+	levels.pop_back();
+	phases.pop_back();
+	increments.pop_back();
+	gains.pop_back();
+}
+
+void OscillatorBank::setFrequency(int index, float freq) {
+	increments[index] = phaseIncrement(freq, sampleRate);
+	levels[index] = tables[index]->levelFor(freq, sampleRate);
+}
+
+void OscillatorBank::fill(float* out, int count) {
+	memset(out, 0, count * sizeof(float));
+
+	for (int o = 0; o < phases.size(); o++) {
+		const float* table = levels[o];
+		unsigned int p = phases[o];
+		unsigned int inc = increments[o];
+		float gain = gains[o];
+
+		for (int i = 0; i < count; i++) {
+			out[i] += lookup(table, p) * gain;
+			p += inc;
+		}
+		phases[o] = p;
+	}
+}
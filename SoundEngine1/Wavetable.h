@@ -0,0 +1,86 @@
+#pragma once
+#ifndef WAVETABLE
+#define WAVETABLE
+#include <vector>
+
+#include "Oscillators.h"
+
+// samples per period in every table (power of two)
+#define WAVETABLE_BITS 11
+#define WAVETABLE_SIZE (1 << WAVETABLE_BITS)
+// one table per octave: level k holds at most WAVETABLE_SIZE / 2 >> k harmonics
+#define WAVETABLE_LEVELS (WAVETABLE_BITS)
+
+enum Waveform {
+	WAVE_SINE,
+	WAVE_TRIANGLE,
+	WAVE_SQUARE,
+	WAVE_SAW
+};
+
+/**
+ * mip-mapped, band-limited single period tables of one waveform
+ * every level is built additively from the waveform's Fourier series, so a
+ * level picked for a given frequency contains no harmonics above Nyquist
+ */
+struct WavetableSet {
+	// WAVETABLE_SIZE + 1 samples per level, the extra one repeats the first for interpolation
+	std::vector<float> levels[WAVETABLE_LEVELS];
+
+	WavetableSet(Waveform wave);
+	// the richest level that does not alias at this frequency
+	const float* levelFor(float freq, unsigned int sampleRate) const;
+};
+
+// shared tables, built on first use
+const WavetableSet& wavetable(Waveform wave);
+
+/**
+ * single wavetable oscillator with a 32 bit fixed point phase accumulator
+ */
+class WavetableOscillator : public Generator {
+private:
+	const WavetableSet* tables;
+	const float* table;		// level picked for the current frequency
+	unsigned int phase = 0;		// full 32 bit range is one period
+	unsigned int increment = 0;
+	unsigned int sampleRate;
+	float amplitude;
+public:
+	WavetableOscillator(Waveform wave = WAVE_SINE, float freq = 440, unsigned int _sampleRate = 22050, float _amplitude = 1);
+
+	void setFrequency(float freq);
+	void setAmplitude(float _amplitude) { amplitude = _amplitude; }
+
+	using Generator::fill;
+	void fill(float* out, int count);
+};
+
+/**
+ * many wavetable oscillators mixed into one output, stored as parallel arrays
+ * so a block for each oscillator is one tight loop over contiguous state
+ */
+class OscillatorBank : public Generator {
+private:
+	std::vector<const WavetableSet*> tables;
+	std::vector<const float*> levels;
+	std::vector<unsigned int> phases;
+	std::vector<unsigned int> increments;
+	std::vector<float> gains;
+	unsigned int sampleRate;
+public:
+	OscillatorBank(unsigned int _sampleRate = 22050) : sampleRate(_sampleRate) {}
+
+	// returns the oscillator's index. Indices stay valid until remove()
+	int add(Waveform wave, float freq, float gain = 1);
+	// swaps the last oscillator into the removed slot
+	void remove(int index);
+	void setFrequency(int index, float freq);
+	void setGain(int index, float gain) { gains[index] = gain; }
+	int size() const { return (int)phases.size(); }
+
+	// writes the sum of all oscillators
+	using Generator::fill;
+	void fill(float* out, int count);
+};
+#endif
@@ -13,24 +13,43 @@
 #define SDL_MAIN_HANDLED
 #include <SDL/SDL.h>
 #include "ALUtilities.h"
+#include "RayTracer.h"
+#include "ImageSource.h"
+#include "TemporalPaths.h"
+#include "Echogram.h"
+#include "VoiceManager.h"
+#include "ALFrame.h"
+#include "ALEvents.h"
+#include "Oscillators.h"
+#include "ProceduralSource.h"
+#include "Noise.h"
+#include "Benchmarks.h"
 
 using namespace std;
 
-int main() {
+int main(int argc, char* argv[]) {
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		runBenchmarks();
+		return 0;
+	}
+
 	//set up openAL context
 	ALCdevice* device;
 	ALCcontext* context;
 	ALSetup(device, context);
+	initALPools();
+	initALFrame();
+	bool eventsEnabled = initALEvents(); //source stops are pushed to us instead of polled when available
 
 	//set up audio sources
 	//set up sources loaded from files
 	//each sound is assigned to keys [1-9]. Press ["] to make them all stop
+	//noise is generated procedurally further down instead of loaded from a file
 	std::vector<std::string> soundFiles({	"./sounds/chirp.wav",
 											"./sounds/sine.wav",
-											"./sounds/sine_beeping.wav",
-											"./sounds/whitenoise.wav" 
+											"./sounds/sine_beeping.wav"
 										});
-	std::vector<soundFile*> soundsFiles = createSounds(soundFiles);
+	std::vector<soundFile*> soundsFiles = createSounds(soundFiles, LOAD_MAPPED);
 
 
 	//set up applications
@@ -47,13 +66,23 @@ int main() {
 	float speed = 0.1;
 	float sensitivity = 0.005; //in degrees?
 	Listener me;
-	//Sphere newSphere;
-	//spheres[0] = newSphere;
 	int rayCount = 200;
+	uint64_t traceFrame = 0; //keys the tracer's random numbers, one per batch
+	ImageSourceEngine earlyReflections(3); //exact specular paths, the image tree is rebuilt only when the scene changes
+	PathCache tracedPaths; //paths found by earlier batches, re-checked instead of searched for again
+
+	//geometry the rays are traced against, built once. Primitives can be added and removed at runtime
+	Scene scene;
+	int sourceMaterial = scene.addMaterial(Material(0.4, true));
+	scene.addSphere(Sphere(glm::vec3(3, 0, 0), 2));
+	scene.addSphere(Sphere(glm::vec3(0, 0, 0), 1, sourceMaterial)); // sound source
+	scene.addTriangle(Triangle(glm::vec3(1, -1, 0), glm::vec3(-1, -1, 0), glm::vec3(0, -1, 1)));
+	scene.addTriangle(Triangle(glm::vec3(-1, -1, 0), glm::vec3(1, -1, 0), glm::vec3(0, -1, -1)));
+	scene.buildBVH(); //rebuild after editing the scene, until then the tracer falls back to testing every primitive
 
 	//set global volume
 	float volume = 1;
-	alListenerf(AL_GAIN, volume); //appears to only accept values between (0,1)
+	setListenerGain(volume); //appears to only accept values between (0,1)
 	//alSourcef(currentSourceID, AL_GAIN, newVolume); //to set volume of a source
 
 	//DONE: try to load in sound one unit at a time
@@ -68,26 +97,44 @@ int main() {
 	//																					Sources must be deleted as soon as they finish playing!!!!
 	//																					Check in like 2-3 frames --> causes noticable tearing
 	
-	sineW mySine;
-	//alBufferData(mySine.bufferid, AL_FORMAT_MONO16, mySine.samples, mySine.buf_size, mySine.sample_rate);
+	const unsigned int sampleRate = 22050;
+	const float toneFreq = 440;
 
-	//testing on playing sound bits :P
-	float segmentIncrement = 0;
+	//segment of the tone, played through the room's impulse response
 	float segmentLen = 0.2;
-	short* soundSegment = mySine.sineSegment(segmentLen, 0, mySine.sample_rate);
-	alBufferData(mySine.bufferid, AL_FORMAT_MONO16, soundSegment, int(segmentLen * mySine.sample_rate), mySine.sample_rate);
-
-	alSourcei(mySine.sourceid, AL_BUFFER, mySine.bufferid);
-	alSourcePlay(mySine.sourceid);
-
-
-	/*sineW mySine2 = sineW(880, 1, 22050);
-	alSourcei(mySine2.sourceid, AL_BUFFER, mySine2.bufferid);
-	alSourcePlay(mySine2.sourceid);
-	alSourcei(mySine2.sourceid, AL_LOOPING, AL_TRUE);*/
+	int segmentSamples = int(segmentLen * sampleRate);
+	//the oscillator keeps its phase between segments, so consecutive segments join up without a click
+	SineOscillator segmentOsc(toneFreq, sampleRate);
+	std::vector<float> drySegment(segmentSamples); //refilled in place, never reallocated
+	std::vector<short> soundSegment(segmentSamples);
+
+	//the tone itself is pulled by the mixer straight from its own oscillator (AL_SOFT_callback_buffer),
+	//so it never has to be stopped, regenerated and restarted like the old 0.2 s segments
+	SineOscillator toneOsc(toneFreq, sampleRate);
+	ProceduralSource tone(&toneOsc, sampleRate);
+	setSourceGain(tone.getSource(), 0); //TODO: set its volume to 0 to see if reflections are working
+	tone.play();
+
+	//the SineWaveC sweep, streamed instead of rendered into one 4 second buffer
+	SweepOscillator sweepOsc(100, 5000, 4410, 44100, 0.5f);
+	ProceduralSource sweep(&sweepOsc, 44100);
+
+	//noise of any length for a few hundred bytes of state each
+	NoiseGenerator whiteNoiseGen(NOISE_WHITE, 0.5f, 1);
+	NoiseGenerator pinkNoiseGen(NOISE_PINK, 1, 2);
+	NoiseGenerator brownNoiseGen(NOISE_BROWN, 1, 3);
+	ProceduralSource whiteNoise(&whiteNoiseGen, 44100);
+	ProceduralSource pinkNoise(&pinkNoiseGen, 44100);
+	ProceduralSource brownNoise(&brownNoiseGen, 44100);
+
+	//procedural sources take the number keys after the sound files: [4] sweep, [5-7] white/pink/brown noise
+	std::vector<ProceduralSource*> procedurals({ &sweep, &whiteNoise, &pinkNoise, &brownNoise });
+
+
+	/*sineW mySine2(880, 1, 22050); //one looping buffer of whole periods, not a second of samples
+	mySine2.play();*/
 
 	//Ray ray;
-	std::vector<reflectInfo> reflectedRays;
 	std::vector<reflectInfo> allReflections;
 
 	/**
@@ -95,127 +142,102 @@ int main() {
 	* play the entire array but for one frame
 	* Then move the buffer elements left by one, calculate the rays, and play the buffer for one frame again
 	*/
-	bool initial = true;
+	//the reflections are summed into an echogram and rendered into one voice that follows the listener
+	//a new segment starts every segmentLen seconds; its reverb tail carries over into the next ones
+	Echogram echogram;
+	EchogramStream reverb;
+	VoiceManager reflectionVoices(64);
+	reflectionVoices.setEventDriven(eventsEnabled);
+	//two buffers take turns, so one can be refilled while the other finishes playing
+	unsigned int reflectionBuffers[2] = { bufferPool().acquire(), bufferPool().acquire() };
+	int reflectionHandles[2] = { 0, 0 };
+	int currentSegment = 0;
+	Uint64 segmentMs = Uint64(segmentLen * 1000);
+	Uint64 nextSegment = SDL_GetTicks64();
+	float frameSeconds = 0;
 
 	while (running) {
 		start = SDL_GetTicks64();
 		
+		//every source and listener change of this frame is handed to the mixer at once in endALFrame()
+		beginALFrame();
+
+		//handle sources that stopped since the last frame
+		sourceEvent stopped;
+		while (pollSourceEvent(stopped))
+			reflectionVoices.sourceStopped(stopped.sourceid);
 		
 		#pragma region RayTracing
-		if(initial){
-			initial = false;
-			//compute all valid rays and reflections
-			for (int i = 0; i < rayCount; i++) {
-				reflectedRays = RayTracer(GetRandomRay(me)); //compute valid reflections of one ray
-				allReflections.insert(allReflections.end(), reflectedRays.begin(), reflectedRays.end()); //bunch up all reflections
-				reflectedRays.clear();
-			}
-			//create sounds at these locations. At the end of the while loop, delete them all. (stored in allReflections)
+		//start a new batch on every segment period, whether or not the previous one found anything
+		if (SDL_GetTicks64() >= nextSegment) {
+			nextSegment += segmentMs;
+			if (SDL_GetTicks64() >= nextSegment)
+				nextSegment = SDL_GetTicks64() + segmentMs; //fell more than a segment behind, start over from now
+
+			currentSegment ^= 1;
+			reflectionVoices.stop(reflectionHandles[currentSegment]); //two periods old, finished unless a frame ran long
+			allReflections.clear(); //clean rays buffer
+
+			//compute all valid rays and reflections, spread over the worker threads
+			tracedPaths.trace(scene, me, rayCount, allReflections, traceFrame++);
+			//plus every specular path of up to 3 reflections, found exactly instead of by chance
+			earlyReflections.trace(scene, me, allReflections);
+			//one impulse response instead of a voice per hit: energy per band over arrival time
 			//cout << "--------------- size: " << allReflections.size() << " ----------------" << endl;
-			for (int i = 0; i < allReflections.size(); i++) {
-				if (allReflections[i].sound.getState() == AL_STOPPED || allReflections[i].sound.getState() == AL_INITIAL) {
-					alSourcef(allReflections[i].sound.sourceid, AL_GAIN, allReflections[i].totalAbsorbed); //to set volume of a source
-					alSource3f(allReflections[i].sound.sourceid, AL_POSITION, allReflections[i].hit.position.x, allReflections[i].hit.position.y, allReflections[i].hit.position.z); // set position at ray
-
-					alBufferData(allReflections[i].sound.bufferid, AL_FORMAT_MONO16, soundSegment, int(segmentLen * mySine.sample_rate), mySine.sample_rate);
-					alSourcei(allReflections[i].sound.sourceid, AL_BUFFER, allReflections[i].sound.bufferid);
-
-					alSourcePlay(allReflections[i].sound.sourceid);
-				}
-			}
-		}
-		else if(allReflections.size() > 0){
-			if(allReflections[0].sound.getState() == AL_STOPPED) {
-				//sources stopped playing, load next batch
-				for (int i = 0; i < allReflections.size(); i++) {
-					alDeleteSources(1, &(allReflections[i].sound.sourceid));
-					alDeleteBuffers(1, &(allReflections[i].sound.bufferid));
-				}
-				allReflections.clear(); //clean rays buffer
-
-				//compute all valid rays and reflections
-				for (int i = 0; i < rayCount; i++) {
-					reflectedRays = RayTracer(GetRandomRay(me)); //compute valid reflections of one ray
-					allReflections.insert(allReflections.end(), reflectedRays.begin(), reflectedRays.end()); //bunch up all reflections
-					reflectedRays.clear();
-				}
-				//create sounds at these locations. At the end of the while loop, delete them all. (stored in allReflections)
-				//cout << "--------------- size: " << allReflections.size() << " ----------------" << endl;
-				for (int i = 0; i < allReflections.size(); i++){
-					if(allReflections[i].sound.getState() == AL_STOPPED || allReflections[i].sound.getState() == AL_INITIAL){
-						alSourcef(allReflections[i].sound.sourceid, AL_GAIN, allReflections[i].totalAbsorbed); //to set volume of a source
-						alSource3f(allReflections[i].sound.sourceid, AL_POSITION, allReflections[i].hit.position.x, allReflections[i].hit.position.y, allReflections[i].hit.position.z); // set position at ray
-
-						alBufferData(allReflections[i].sound.bufferid, AL_FORMAT_MONO16, soundSegment, int(segmentLen * mySine.sample_rate), mySine.sample_rate);
-						alSourcei(allReflections[i].sound.sourceid, AL_BUFFER, allReflections[i].sound.bufferid);
-				
-						alSourcePlay(allReflections[i].sound.sourceid);
-					}
-				}
-			}
+			echogram.clear();
+			echogram.addPaths(allReflections);
+			segmentOsc.fill(drySegment.data(), segmentSamples);
+			reverb.render(echogram, drySegment.data(), segmentSamples, sampleRate, soundSegment.data(), traceFrame);
+			alBufferData(reflectionBuffers[currentSegment], AL_FORMAT_MONO16, soundSegment.data(), segmentSamples * sizeof(short), sampleRate);
+			reflectionHandles[currentSegment] = reflectionVoices.play(reflectionBuffers[currentSegment], me.pos, 1);
 		}
-		else if (allReflections.size() <= 0) { initial = true; }
-		else { cout << "unhandled exception" << endl; }
+		reflectionVoices.setPosition(reflectionHandles[currentSegment], me.pos);
+		reflectionVoices.update(me, frameSeconds);
 		#pragma endregion RayTracing
 		
 
 		//process key inputs
-		keyInput(running, speed, sensitivity, me, soundsFiles);
+		keyInput(running, speed, sensitivity, me, soundsFiles, &procedurals);
 
 		//position of sound source for sounds loaded from file
 		for (int i = 0; i < soundsFiles.size(); i++) {
-			alSource3f(soundsFiles[i]->sourceid, AL_POSITION, soundsFiles[i]->pos.x, soundsFiles[i]->pos.y, soundsFiles[i]->pos.z);
-			alSourcei(soundsFiles[i]->sourceid, AL_LOOPING, AL_TRUE); // makes the sound continuously loop once initiated
-		}
-
-		//TODO: set its volume to 0 to see if reflections are working
-		// This attempts to play one bit of the sine wave
-		// While it technically works, the process can cause some audio tearing
-		// Overall, it works as well as playing the audio non-stop
-		#pragma region playBit
-		if (mySine.getState() == AL_STOPPED) {
-			segmentIncrement += segmentLen;
-			delete[] soundSegment;
-			soundSegment = mySine.sineSegment(segmentLen, segmentIncrement, mySine.sample_rate);
-			
-			alDeleteSources(1, &(mySine.sourceid));
-			alBufferData(mySine.bufferid, AL_FORMAT_MONO16, soundSegment, int(segmentLen * mySine.sample_rate), mySine.sample_rate);
-			alGenSources(1, &(mySine.sourceid));
-			alSourcei(mySine.sourceid, AL_BUFFER, mySine.bufferid);
-
-			alSourcef(mySine.sourceid, AL_GAIN, 0); //to set volume of a source
-			alSourcePlay(mySine.sourceid);
+			setSourcePosition(soundsFiles[i]->sourceid, soundsFiles[i]->pos);
+			setSoundLooping(*soundsFiles[i], true); // makes the sound continuously loop once initiated
 		}
-		#pragma endregion playBit
 
-		// activate if playing a whole array (!playBit)
-		//alSourcei(mySine.sourceid, AL_LOOPING, AL_TRUE);
+		//keeps the queued fallback rings filled if callback buffers are unavailable
+		tone.update();
+		for (int i = 0; i < procedurals.size(); i++)
+			procedurals[i]->update();
 		
 		//position of listener
-		float playerVec[] = { me.f.x, me.f.y, me.f.z,//forward
-							me.up.x, me.up.y, me.up.z };//up
-		alListenerfv(AL_ORIENTATION, playerVec);
+		setListenerOrientation(me.f, me.up);
+		endALFrame();
 		
 		//necessary for sound playing when moving
+		//a source stopping ends the wait early so it is refilled/recycled without waiting out the frame
 		if (1000 / 30 > SDL_GetTicks64() - start) {
-			SDL_Delay(1000 / 30 - (SDL_GetTicks64() - start));
+			waitForSourceEvent(1000 / 30 - (SDL_GetTicks64() - start));
 		}
+		frameSeconds = (SDL_GetTicks64() - start) / 1000.0f;
 		cout << "FPS: " << (SDL_GetTicks64() - start) << endl;
+		cout << "AL calls: " << frameCallStats().made << " made, " << frameCallStats().skipped << " skipped" << endl;
+		cout << "voices: " << reflectionVoices.getStats().real << " real, " << reflectionVoices.getStats().virtualized << " virtual" << endl;
 	}
 
 	//program termination
-	alDeleteSources(1, &(mySine.sourceid));
-	alDeleteBuffers(1, &(mySine.bufferid));
-	delete[] mySine.samples;
-	delete[] soundSegment;
-
-	//sources stopped playing, load next batch
-	for (int i = 0; i < allReflections.size(); i++) {
-		alDeleteSources(1, &(allReflections[i].sound.sourceid));
-		alDeleteBuffers(1, &(allReflections[i].sound.bufferid));
-	}
+	tone.close();
+	for (int i = 0; i < procedurals.size(); i++)
+		procedurals[i]->close();
+
 	allReflections.clear(); //clean rays buffer
+	reflectionVoices.stopAll();
+	bufferPool().release(reflectionBuffers[0]);
+	bufferPool().release(reflectionBuffers[1]);
 
+	printPoolStats();
+	shutdownALEvents();
+	freeALPools();
 	deleteSoundFiles(soundsFiles);
 	freeContext(device, context);
 	return 0;